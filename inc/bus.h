@@ -0,0 +1,89 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BUS_H
+#define BUS_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <functional>
+
+class Bus : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * Connects the levels above it to `lower'. One request holds the bus at a time, from the
+	 * cycle it is granted until its data has crossed. Waiting requesters are granted it
+	 * ROUND_ROBIN by default.
+	 * @param The level of storage requests are forwarded to.
+	 * @param The number of words moved per bus cycle.
+	 * @param The number of clock cycles per bus cycle.
+	 * @return A new, idle bus.
+	 */
+	Bus(Storage *lower, int width, int ratio);
+	~Bus();
+
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word(void *, int, signed int &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int write_victim(void *, std::array<signed int, LINE_SIZE>, int, int) override;
+	/**
+	 * Forwards the burst to `lower' as one request, then holds the bus while its words cross.
+	 */
+	int write_lines(void *, const std::vector<LineWrite> &) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word_non_temporal(void *, int, signed int &) override;
+	int read_words_non_temporal(
+		void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int write_word_non_temporal(void *, signed int, int) override;
+	int back_invalidate(int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * @return the inclusion policy of `lower'
+	 */
+	enum Inclusion get_inclusion() const override;
+	/**
+	 * @param the number of clock cycles simulated
+	 * @return the fraction of those cycles the bus was held
+	 */
+	double get_utilization(unsigned long cycles) const;
+
+  private:
+	/**
+	 * Forwards the request to `lower', calling `request_handler' with the address every cycle
+	 * until it sets `served', then holds the bus while `words' words cross it.
+	 */
+	int process(
+		void *id, int address, std::function<void(int index, int offset)> request_handler) override;
+	/**
+	 * The number of words moved per bus cycle, and the number of clock cycles per bus cycle.
+	 */
+	int width;
+	int ratio;
+	/**
+	 * The number of words the current request moves.
+	 */
+	int words;
+	/**
+	 * Nonzero once `lower' has completed the current request.
+	 */
+	int served;
+};
+
+#endif /* BUS_H_INCLUDED */
@@ -21,8 +21,14 @@
 #include "storage.h"
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <list>
+#include <map>
 #include <ostream>
+#include <unordered_map>
+#include <unordered_set>
 
 /**
  * Parse an address into a tag, index into the cache table, and a line
@@ -39,10 +45,78 @@
     *(o) = GET_LS_BITS(a, LINE_SPEC)
 // clang-format on
 
+/**
+ * The number of prefetches a cache holds before refusing more.
+ */
+#define PREFETCH_QUEUE_SIZE 8
+
+/**
+ * How a cache maps a line to a set. MODULO takes the set from the low bits of the line address.
+ * XOR_FOLD XORs together every set-sized field of the line address, and PRIME_MODULO takes the
+ * line address modulo the largest prime no greater than the number of sets. SKEWED gives each way
+ * its own XOR of the low set-sized field with the next, rotated by the way number, so lines which
+ * conflict in one way rarely conflict in the others.
+ */
+enum Indexing { MODULO, XOR_FOLD, PRIME_MODULO, SKEWED };
+
+/**
+ * Selects which lines `Cache::lines' visits.
+ */
+enum LineFilter { VALID_LINES, DIRTY_LINES };
+
+/**
+ * A line held by a cache, as visited by `Cache::lines'.
+ */
+struct CacheLine {
+	/**
+	 * The true index of the line, and the address of its first word.
+	 */
+	int index;
+	int address;
+	const std::array<signed int, 3> *meta;
+	const std::array<signed int, LINE_SIZE> *data;
+};
+
 class Cache : public Storage
 {
   public:
 	/**
+	 * A read-only iterator over the lines of a cache which pass a filter.
+	 */
+	class LineIterator
+	{
+	  public:
+		LineIterator(const Cache *cache, int index, enum LineFilter filter);
+		CacheLine operator*() const;
+		LineIterator &operator++();
+		bool operator!=(const LineIterator &other) const;
+
+	  private:
+		/**
+		 * Advances `index' to the next line which passes `filter', or to the end.
+		 */
+		void skip();
+		const Cache *cache;
+		int index;
+		enum LineFilter filter;
+	};
+
+	/**
+	 * The lines of a cache which pass a filter, as returned by `Cache::lines'.
+	 */
+	class LineRange
+	{
+	  public:
+		LineRange(const Cache *cache, enum LineFilter filter);
+		LineIterator begin() const;
+		LineIterator end() const;
+
+	  private:
+		const Cache *cache;
+		enum LineFilter filter;
+	};
+
+	/**
 nn	 * Constructor.
 	 * @param The number of `lines` contained in memory. The total number of
 	 * words is this number multiplied by LINE_SIZE.
@@ -61,7 +135,155 @@ nn	 * Constructor.
 	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
 	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
 	int read_word(void *, int, signed int &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int write_victim(void *, std::array<signed int, LINE_SIZE>, int, int) override;
+	/**
+	 * Places the burst as one request. Each line is placed as a write to it would be, and the
+	 * request then takes `delay' cycles, and one more for each line after the first.
+	 */
+	int write_lines(void *, const std::vector<LineWrite> &) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int back_invalidate(int, std::array<signed int, LINE_SIZE> &) override;
+	int maintain(void *, enum Maintenance, int, int) override;
+	int prefetch(void *, int, int) override;
+	int read_word_non_temporal(void *, int, signed int &) override;
+	int read_words_non_temporal(
+		void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int write_word_non_temporal(void *, signed int, int) override;
+	/**
+	 * Issues the oldest queued prefetch when this cache is idle, and advances it.
+	 */
+	void tick() override;
 	unsigned int get_size();
+	/**
+	 * @param the index of an element in `this->data'
+	 * @return a read-only reference to that element's tag, dirty and usage metadata
+	 */
+	const std::array<signed int, 3> &view_meta(int index) const;
+	/**
+	 * @param VALID_LINES to visit every line held, DIRTY_LINES to visit only dirty lines
+	 * @return the lines held which pass `filter', without copying them
+	 */
+	LineRange lines(enum LineFilter filter) const;
+	/**
+	 * Sets the inclusion policy this cache keeps with respect to the caches filled from it.
+	 * @param the new policy
+	 */
+	void set_inclusion(enum Inclusion inclusion);
+	/**
+	 * Divides each line into `1 << sector_spec' sectors with their own valid and dirty bits.
+	 * Misses fetch only the sectors the request needs, plus the `neighbors' sectors after them,
+	 * and evictions write back only the dirty sectors. Disabled if `sector_spec' is 0. Throws
+	 * std::invalid_argument if a sector would be smaller than a word, or if this cache is
+	 * EXCLUSIVE.
+	 * @param the number of bits required to specify a sector within a line
+	 * @param the number of sectors after those needed to fetch with them
+	 */
+	void set_sectors(unsigned int sector_spec, unsigned int neighbors);
+	/**
+	 * Sets the function mapping lines to sets. Tags hold the whole line address unless `indexing'
+	 * is MODULO. Discards the current contents of the cache. Throws std::invalid_argument if
+	 * `indexing' is SKEWED and compression or way prediction is enabled.
+	 * @param the new index function
+	 */
+	void set_indexing(enum Indexing indexing);
+	/**
+	 * @param the index of an element in `this->data'
+	 * @return the words of that element which are valid, bit i for word i
+	 */
+	unsigned int get_valid_words(int index) const;
+	/**
+	 * @param the index of an element in `this->data'
+	 * @return the words of that element which are dirty, bit i for word i
+	 */
+	unsigned int get_dirty_words(int index) const;
+	/**
+	 * Enables or disables critical-word-first fills. When enabled, a `read_word' which misses
+	 * completes the cycle its word arrives from `lower', and the remaining words of the line
+	 * arrive one per cycle after it.
+	 * @param nonzero to enable
+	 */
+	void set_critical_word_first(int enable);
+	/**
+	 * Enables compression. Each set holds `1 << tag_spec' times as many tags as it has ways, but
+	 * only as many lines' worth of data, with lines stored zero-line or base-delta-immediate
+	 * compressed. Lines are evicted until the compressed lines in a set fit. Discards the current
+	 * contents of the cache, and `get_data' becomes indexed by tag entry.
+	 * @param the number of bits added to each set to specify a tag entry
+	 * @param the number of extra clock cycles a hit on a base-delta line takes
+	 */
+	void set_compression(unsigned int tag_spec, int decompress_delay);
+	/**
+	 * @return the uncompressed size of the lines held divided by their compressed size
+	 */
+	double get_compression_ratio() const;
+	/**
+	 * Enables MRU way prediction. Each set predicts the way it last hit or filled, and hits in the
+	 * predicted way take `fast_delay' clock cycles. Hits in any other way take `penalty' clock cycles
+	 * more than an unpredicted hit. Prediction only changes timing, as lines are found by lookup
+	 * whichever way holds them.
+	 * @param the number of clock cycles a correctly predicted hit takes
+	 * @param the number of extra clock cycles a mispredicted hit takes
+	 */
+	void set_way_prediction(int fast_delay, int penalty);
+	/**
+	 * Places `id' in a partition. Requesters are in partition 0 until placed.
+	 * @param the requester
+	 * @param the partition
+	 */
+	void set_partition(void *id, unsigned int partition);
+	/**
+	 * Restricts the ways requesters in `partition' may fill lines into. Hits may be in any way.
+	 * Partitions may fill any way until restricted. Throws std::invalid_argument unless `ways'
+	 * has one element per way and selects at least one.
+	 * @param the partition
+	 * @param the ways lines may be filled into, element i for way i
+	 */
+	void set_way_mask(unsigned int partition, const std::vector<bool> &ways);
+	/**
+	 * As above, for caches of up to 64 ways. Throws std::invalid_argument if `mask' is zero or
+	 * selects a way not held.
+	 * @param the partition
+	 * @param the ways lines may be filled into, bit i for way i
+	 */
+	void set_way_mask(unsigned int partition, unsigned long mask);
+	/**
+	 * Enables utility-based partitioning. Shadow tags are kept for each partition, recording the
+	 * hits it would have had with each number of ways to itself. Every `interval' accesses, the
+	 * ways are divided into contiguous masks, one per partition, to maximize those hits. Disabled
+	 * if `interval' is 0.
+	 * @param the number of accesses between repartitions
+	 */
+	void set_dynamic_partitioning(unsigned long interval);
+	/**
+	 * Enables or disables classifying misses. Misses on lines never accessed before are
+	 * compulsory. Other misses are capacity misses if a fully associative LRU cache of the same
+	 * number of lines would also have missed, and conflict misses otherwise.
+	 * @param nonzero to enable
+	 */
+	void set_miss_classification(int enable);
+	/**
+	 * @param a partition
+	 * @return the ways `partition' may fill lines into, element i for way i
+	 */
+	const std::vector<bool> &get_ways(unsigned int partition) const;
+	/**
+	 * Throws std::out_of_range if this cache has more than 64 ways.
+	 * @param a partition
+	 * @return the ways `partition' may fill lines into, bit i for way i
+	 */
+	unsigned long get_way_mask(unsigned int partition) const;
+	/**
+	 * @param a partition
+	 * @return the number of lines held which were filled by `partition'
+	 */
+	unsigned long get_occupancy(unsigned int partition) const;
+	/**
+	 * @param a partition
+	 * @param HITS or MISSES
+	 * @return the value of the counter `s' for accesses by `partition'
+	 */
+	unsigned long get_partition_stat(unsigned int partition, enum Stat s) const;
 
   private:
 	int process(
@@ -75,14 +297,222 @@ nn	 * Constructor.
 	 */
 	int priming_address(int address);
 	/**
-	 * Searches the set of ways in cache belonging to `index' for `tag'. If a match is found,
-	 * returns the true index into the table. If a match is not found, returns a address suitable to
-	 * replace, dictated by the LRU replacement policy..
+	 * Helper for priming_address.
+	 * Writes back the line at `t_index' if required, then invalidates it. The upper levels are
+	 * back-invalidated first if this cache is inclusive.
+	 * @param the true index of the line
+	 * @return 1 if the line is gone and the caller may proceed this cycle, 0 otherwise.
+	 */
+	int evict_line(int t_index);
+	/**
+	 * Helper for priming_address.
+	 * Reads the line at `t_index' from `lower', or when sectored, only its invalid sectors which
+	 * the current request needs, along with their neighbors.
+	 * @param the address being accessed
+	 * @param the true index of the line
+	 * @return 1 if the fill has arrived, 0 otherwise.
+	 */
+	int fill(int address, int t_index);
+	/**
+	 * Writes the line at `t_index' to `lower', or when sectored, only its dirty words, or its
+	 * valid words if `lower' is EXCLUSIVE. The line is clean once this returns 1.
+	 * @param the true index of the line
+	 * @param the address of the first word of the line
+	 * @return 1 if the write has completed, 0 otherwise.
+	 */
+	int write_back(int t_index, int address);
+	/**
+	 * @param the true index of a valid line
+	 * @return the words of the line `write_back' writes, bit i for word i
+	 */
+	unsigned int written_words(int t_index) const;
+	/**
+	 * Marks the line at `t_index' dirty, and when sectored, the valid words of it in `words'.
+	 * @param the true index of the line
+	 * @param the words written, bit i for word i
+	 */
+	void mark_dirty(int t_index, unsigned int words);
+	/**
+	 * @param a set of words, bit i for word i
+	 * @return every word in a sector containing one of `words'
+	 */
+	unsigned int expand(unsigned int words) const;
+	/**
+	 * @param the true index of a valid line
+	 * @return the address of the first word of that line
+	 */
+	int line_address(int t_index) const;
+	/**
+	 * Parses `address' into a tag, the set it maps to, and a line offset. Under SKEWED indexing,
+	 * the set is the one it maps to in way 0.
+	 * @param the address to be parsed
+	 * @param the resulting tag
+	 * @param the resulting set
+	 * @param the resulting offset
+	 */
+	void get_fields(int address, int *tag, int *index, int *offset) const;
+	/**
+	 * @param the line address being placed
+	 * @param the way it is being placed in
+	 * @return the set `line' maps to in `way' under the current index function
+	 */
+	int hash_line(int line, int way) const;
+	/**
+	 * @param the set a line maps to in way 0
+	 * @param the tag of the line
+	 * @param an entry of the set, from 0 to the number of tag entries per set
+	 * @return the true index of that entry for the line
+	 */
+	int entry(int index, int tag, int i) const;
+	/**
+	 * Helper for priming_address when compression is enabled.
+	 * Evicts the least recently used line other than `t_index' if the set holds more compressed
+	 * data than it has room for.
+	 * @param the set to check
+	 * @param the true index of the line being accessed
+	 * @return 1 if a line is being evicted, 0 if the set fits.
+	 */
+	int make_room(int index, int t_index);
+	/**
+	 * Helper for maintain. Fills `batch' with the true index of every line which passes `filter'
+	 * and contains an address in [`start', `end'). Looks each line of the range up if the range
+	 * is smaller than the cache, and scans the cache otherwise.
+	 * @param the lines to collect
+	 * @param the first address in the range
+	 * @param the address after the last in the range
+	 */
+	void collect(enum LineFilter filter, int start, int end);
+	/**
+	 * Zero lines take one byte, and lines of one repeated word take one word. Otherwise, lines
+	 * take a base word followed by one or two bytes per word of delta from it, or are stored
+	 * uncompressed.
+	 * @param a line of data
+	 * @return the number of bytes `line' compresses to
+	 */
+	static int compressed_size(const std::array<signed int, LINE_SIZE> &line);
+	/**
+	 * Charges the decompression latency of `index' on the first cycle it is checked for the
+	 * current request.
+	 * @param the true index being accessed
+	 * @return 1 if the line is still being decompressed, 0 otherwise
+	 */
+	int is_decompressing(int index);
+	/**
+	 * Charges the latency of a hit on `index' given the way predicted for its set, on the first
+	 * cycle it is checked for the current request.
+	 * @param the true index being accessed
+	 */
+	void check_prediction(int index);
+	/**
+	 * @param a requester
+	 * @return the partition `id' is in
+	 */
+	unsigned int partition_of(void *id) const;
+	/**
+	 * Creates partitions up to and including `partition', each allowed to fill any way.
+	 * @param a partition
+	 */
+	void add_partitions(unsigned int partition);
+	/**
+	 * Helper for record_access. Updates the shadow tags of the partition being served, then
+	 * repartitions the ways if the interval has passed.
+	 * @param the true index which was accessed
+	 */
+	void track_utility(int index);
+	/**
+	 * Divides the ways between the partitions by their recorded utility.
+	 */
+	void repartition();
+	/**
+	 * Helper for record_access. Classifies the current request if it missed, then records the
+	 * access in the fully associative shadow cache.
+	 */
+	void classify_access();
+	/**
+	 * Helper for read_line when this cache is EXCLUSIVE.
+	 * Hits are handed to the requester and dropped from this level. Misses are read straight from
+	 * `lower' into the requester, without allocating a line here.
+	 * @param the source making the request.
+	 * @param the address being accessed.
+	 * @param the data being returned
+	 * @return 1 if the request was completed, 0 otherwise
+	 */
+	int read_line_exclusive(void *id, int address, std::array<signed int, LINE_SIZE> &data_line);
+	/**
+	 * Helper for read_word when critical-word-first fills are enabled.
+	 * Completes a miss the cycle the fill arrives, and completes hits on a streaming line once
+	 * the requested word has arrived.
+	 * @param the source making the request.
+	 * @param the address being accessed.
+	 * @param the data being returned
+	 * @return 1 if the request was completed, 0 otherwise
+	 */
+	int read_word_early(void *id, int address, signed int &data);
+	/**
+	 * Helper for process. Updates the replacement and hit/miss state after an access to `index'.
+	 * @param the true index which was accessed
+	 */
+	void record_access(int index);
+	/**
+	 * Advances the line currently streaming in by one cycle.
+	 */
+	void advance_stream();
+	/**
+	 * @param the true index being accessed
+	 * @param the word being accessed, or -1 if the whole line is needed
+	 * @return 1 if the requested data has not yet streamed into `index', 0 otherwise
+	 */
+	int is_streaming(int index, int offset);
+	/**
+	 * Searches the ways `tag' may be held in for it, starting from the set `index'. If a match is found,
+	 * returns the true index into the table. Lines are found through `lookup' in constant time. If
+	 * a match is not found, returns a address suitable to replace, dictated by the LRU replacement
+	 * policy among the ways the partition being served may fill. The victim is taken from the
+	 * recency lists of the set unless partitions or SKEWED indexing are in use, which scan the
+	 * ways.
 	 * @param an index aligned to the set of ways in `this->data'
 	 * @param the tag to be matched
 	 * @return the true index if the tag is present, or the index to be replaced if not.
 	 */
 	int search_ways_for(int true_index, int tag);
+	/**
+	 * Sets the tag of the line at `t_index', keeping `lookup' in sync.
+	 * @param the true index of the line
+	 * @param the new tag, or -1 to mark the line invalid
+	 */
+	void set_tag(int t_index, int tag);
+	/**
+	 * Sets the usage of the line at `t_index', keeping the recency lists of its set in sync.
+	 * @param the true index of the line
+	 * @param the access number the line was last used at, or -1 to make it next to be replaced
+	 */
+	void set_usage(int t_index, int usage);
+	/**
+	 * Marks the line at `t_index' invalid, clean and unused.
+	 * @param the true index of the line
+	 */
+	void clear_line(int t_index);
+	/**
+	 * @param a line address
+	 * @return the true index holding `line', or -1 if it is not held
+	 */
+	int find_line(int line) const;
+	/**
+	 * @param a line address
+	 * @return the slot of `lookup' the search for `line' starts at
+	 */
+	unsigned int hash_key(int line) const;
+	/**
+	 * @param a set
+	 * @return the true index of the entry in `set' with the lowest usage, taking the lowest index
+	 * of those never used
+	 */
+	int least_recent(int set) const;
+	/**
+	 * Rebuilds `lookup', the recency lists and `unused' from `meta', after it is resized or
+	 * cleared.
+	 */
+	void rebuild_lookup();
 	/**
 	 * The number of bits required to specify a line in this level of cache.
 	 */
@@ -96,6 +526,166 @@ nn	 * Constructor.
 	 * The current access number. Used to assign usage data for the LRU replacement policy.
 	 */
 	unsigned int access_num;
+	/**
+	 * Nonzero if the current request missed. Set on the first cycle the miss is seen.
+	 */
+	int missed;
+	/**
+	 * Nonzero if the current request's fill arrived from `lower'.
+	 */
+	int filled;
+	/**
+	 * Nonzero if `read_word' misses forward the critical word as soon as it arrives.
+	 */
+	int critical_word_first;
+	/**
+	 * The true index of the line still streaming in after an early restart, or -1 if there is
+	 * none, the word which was forwarded first, and the number of cycles since it arrived.
+	 */
+	int stream_index;
+	int stream_word;
+	int stream_elapsed;
+	/**
+	 * Nonzero once the line being evicted has been counted and back-invalidated.
+	 */
+	int evicting;
+	/**
+	 * The number of bits added to each set to specify a tag entry. Nonzero if compression is
+	 * enabled.
+	 */
+	unsigned int tag_spec;
+	/**
+	 * The number of extra clock cycles a hit on a base-delta compressed line takes.
+	 */
+	int decompress_delay;
+	/**
+	 * Nonzero once the decompression latency of the current request has been charged, and the
+	 * cycles of it left.
+	 */
+	int charged;
+	int penalty;
+	/**
+	 * Nonzero if way prediction is enabled, the number of clock cycles a correctly predicted hit
+	 * takes, and the number of extra clock cycles a mispredicted hit takes.
+	 */
+	int way_prediction;
+	int fast_delay;
+	int mispredict_penalty;
+	/**
+	 * Nonzero once the way prediction of the current request has been checked.
+	 */
+	int guessed;
+	/**
+	 * The way predicted for each set.
+	 */
+	std::vector<int> predicted;
+	/**
+	 * The state kept for each partition: the ways it may fill, its hit and miss counts, and
+	 * for utility-based partitioning, its shadow tags and the hits at each recency position.
+	 */
+	struct Partition {
+		std::vector<bool> ways;
+		std::array<unsigned long, 2> counts;
+		std::vector<std::vector<int>> shadow;
+		std::vector<unsigned long> utility;
+	};
+	std::vector<Partition> partitions;
+	/**
+	 * The partition of each requester which has been placed, and of the request being served.
+	 */
+	std::map<void *, unsigned int> placement;
+	unsigned int active;
+	/**
+	 * The partition which filled each element in `data', if partitions are in use.
+	 */
+	std::vector<unsigned int> owner;
+	/**
+	 * The number of accesses between repartitions, or 0, and the number since the last.
+	 */
+	unsigned long interval;
+	unsigned long since;
+	/**
+	 * Nonzero if misses are classified, the lines which have been accessed, and the lines a
+	 * fully associative LRU cache of the same size would hold, most recently used first, with
+	 * the position of each.
+	 */
+	int classify;
+	std::unordered_set<int> touched;
+	std::list<int> fa_order;
+	std::unordered_map<int, std::list<int>::iterator> fa_lines;
+	/**
+	 * The number of bits required to specify a sector, nonzero if this cache is sectored, and the
+	 * number of sectors fetched after those needed.
+	 */
+	unsigned int sector_spec;
+	unsigned int neighbors;
+	/**
+	 * The valid and dirty words of each element in `data', if this cache is sectored.
+	 */
+	std::vector<unsigned int> valid_words;
+	std::vector<unsigned int> dirty_words;
+	/**
+	 * The words the current request reads or writes, bit i for word i.
+	 */
+	unsigned int access_mask;
+	/**
+	 * The function mapping lines to sets, and under PRIME_MODULO, the number of sets used.
+	 */
+	enum Indexing indexing;
+	int prime;
+	/**
+	 * Nonzero while serving a non-temporal access.
+	 */
+	int non_temporal;
+	/**
+	 * The line being placed by `write_victim' or `write_lines', or nullptr.
+	 */
+	const std::array<signed int, LINE_SIZE> *victim;
+	/**
+	 * The addresses of the lines waiting to be prefetched, oldest first, and of the lines
+	 * prefetched which have not yet been accessed.
+	 */
+	std::deque<int> prefetches;
+	std::unordered_set<int> prefetched;
+	/**
+	 * The compressed size in bytes of each element in `data'.
+	 */
+	std::vector<int> csize;
+	/**
+	 * 1 while a maintenance operation is in progress, 2 once `lower' has completed it, 0 otherwise.
+	 */
+	int maintaining;
+	/**
+	 * The lines the current maintenance operation applies to, and the dirty lines it is writing
+	 * back.
+	 */
+	std::vector<int> batch;
+	std::vector<LineWrite> burst;
+	/**
+	 * The number of lines of the burst being served which have been placed. Only the requester
+	 * holding this level advances it.
+	 */
+	unsigned long burst_placed;
+	/**
+	 * An open-addressed table of the line address and true index of each valid element in `data',
+	 * with -1 in empty slots, and the shift taking a hashed line address to a slot.
+	 */
+	std::vector<std::array<int, 2>> lookup;
+	unsigned int lookup_shift;
+	/**
+	 * The elements of each set with a nonnegative usage, linked from least to most recently used,
+	 * with the first and last of each set, or -1 if there are none.
+	 */
+	std::vector<int> lru_prev;
+	std::vector<int> lru_next;
+	std::vector<int> lru_head;
+	std::vector<int> lru_tail;
+	/**
+	 * The elements of each set with a negative usage, `unused_words' words per set, bit i for
+	 * entry i.
+	 */
+	std::vector<std::uint64_t> unused;
+	int unused_words;
 	/**
 	 * An array of metadata about elements in `data`.
 	 * If the first value of an element is negative, the corresponding
@@ -0,0 +1,56 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CONFIG_H
+#define CONFIG_H
+#include "storage.h"
+#include "topology.h"
+#include <istream>
+
+/**
+ * Builds a hierarchy from a config with one level per line, lowest level first. Each line names
+ * a kind of level followed by `key=value' options. Every level but the first is built over the
+ * level before it, or over the level named by its `lower' option, so levels may share the level
+ * below them. Text after `#' is ignored.
+ *
+ *	dram delay=4
+ *	bus width=2 ratio=1
+ *	cache name=l2 size=7 ways=1 delay=2 inclusion=inclusive arbitration=oldest queue=4
+ *	icache name=l1i size=5 ways=1 delay=1
+ *	cache name=l1d lower=l2 size=5 ways=1 delay=1 cwf=1 predict=0,1 compress=2,1
+ *	storebuffer entries=8
+ *	scratchpad name=spm base=0x3000 lines=256 delay=1
+ *	router scratchpad=spm
+ *
+ * `dram' takes `delay'. `bus' takes `width' and `ratio'. `storebuffer' takes `entries'.
+ * `scratchpad' takes `base', `lines' and `delay'; it is built over no level, and the line after
+ * it is built over the level before it. `router' takes the name of a `scratchpad' to send its
+ * addresses to, sending all others to the level below. `icache' takes `size', `ways' and `delay'.
+ * `cache' takes the same, and optionally `inclusion' (non-inclusive, inclusive or exclusive),
+ * `index' (modulo, xor, prime or skewed), `cwf' to enable critical-word-first fills, `classify'
+ * to enable miss classification, `predict' as the arguments to `set_way_prediction', `compress'
+ * as the arguments to `set_compression', and `sectors' as the arguments to `set_sectors'. Any
+ * level may be given an `arbitration' policy (first-come, round-robin, priority or oldest) with
+ * an optional `queue' depth, and a `name'; levels are otherwise named after their kind and
+ * position. Throws std::invalid_argument on a malformed config, leaving `topology' empty.
+ * @param the config to read
+ * @param cleared, then given the levels built, lowest first
+ * @return the level on the last line other than a scratchpad
+ */
+Storage *build_hierarchy(std::istream &config, Topology &topology);
+
+#endif /* CONFIG_H_INCLUDED */
@@ -0,0 +1,127 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DMA_H
+#define DMA_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <deque>
+
+class Dma
+{
+  public:
+	/**
+	 * Constructor.
+	 * The engine reads and writes as two separate requesters, so a read may be in flight while
+	 * earlier lines are still being written.
+	 * @param The level of storage transfers are issued to. Attaching to a lower level bypasses
+	 * the caches above it.
+	 * @param Nonzero if the levels above `target' should be kept coherent with transfers. Dirty
+	 * copies of source lines are written to `target' before being copied, and copies of
+	 * destination lines are dropped.
+	 * @param The number of lines which may be buffered between being read and written.
+	 * @return A new, idle DMA engine.
+	 */
+	Dma(Storage *target, int coherent, int depth);
+
+	/**
+	 * Begins copying `n_lines' lines starting at `src' to `dst'. The ranges must not overlap.
+	 * @param the source address
+	 * @param the destination address
+	 * @param the number of lines to copy
+	 * @return 1 if the transfer was started, 0 if a transfer is already in progress
+	 */
+	int copy_block(int src, int dst, int n_lines);
+	/**
+	 * Begins writing `data_line' to each of `n_lines' lines starting at `dst'.
+	 * @param the destination address
+	 * @param the line to write
+	 * @param the number of lines to write
+	 * @return 1 if the transfer was started, 0 if a transfer is already in progress
+	 */
+	int fill_block(int dst, std::array<signed int, LINE_SIZE> data_line, int n_lines);
+	/**
+	 * Advances the current transfer by one clock cycle.
+	 * @return 1 if no transfer is in progress after this cycle, 0 otherwise
+	 */
+	int tick();
+	/**
+	 * @return 1 if a transfer is in progress, 0 otherwise
+	 */
+	int is_busy() const;
+	/**
+	 * @return the number of words moved per cycle by the last completed transfer
+	 */
+	double get_bandwidth() const;
+	/**
+	 * @return the number of cycles the last completed transfer took
+	 */
+	unsigned long get_cycles() const;
+
+  private:
+	/**
+	 * Helper for tick. Advances the read of the next source line by one cycle.
+	 */
+	void advance_read();
+	/**
+	 * Helper for tick. Advances the write of the oldest buffered line by one cycle.
+	 */
+	void advance_write();
+	Storage *target;
+	int coherent;
+	int depth;
+	/**
+	 * The requester ids reads and writes are issued under.
+	 */
+	int reader;
+	int writer;
+	/**
+	 * The source and destination addresses, and the number of lines in the transfer.
+	 * A negative source denotes a fill.
+	 */
+	int src;
+	int dst;
+	int n_lines;
+	/**
+	 * The number of lines read and written so far.
+	 */
+	int read_next;
+	int write_next;
+	/**
+	 * Nonzero while a read or write has been issued and not completed. For reads, 2 once the line
+	 * has been read and is being written back with an upper level's dirty words merged in.
+	 */
+	int reading;
+	int writing;
+	/**
+	 * The line being read, and lines waiting to be written.
+	 */
+	std::array<signed int, LINE_SIZE> incoming;
+	std::deque<std::array<signed int, LINE_SIZE>> buffer;
+	/**
+	 * Cycles spent on the current transfer.
+	 */
+	unsigned long cycles;
+	/**
+	 * The length in cycles and lines of the last completed transfer.
+	 */
+	unsigned long last_cycles;
+	int last_lines;
+};
+
+#endif /* DMA_H_INCLUDED */
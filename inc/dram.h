@@ -37,6 +37,13 @@ class Dram : public Storage
 	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
 	int read_word(void *, int, signed int &) override;
 	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * Writes the burst as one request. The first line takes `delay' cycles, and each line after
+	 * it one cycle more, as the rows are streamed in back to back.
+	 */
+	int write_lines(void *, const std::vector<LineWrite> &) override;
 
 	/**
 	 * TODO This will accept a file at a later date.
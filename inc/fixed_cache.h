@@ -0,0 +1,324 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef FIXED_CACHE_H
+#define FIXED_CACHE_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <climits>
+#include <functional>
+
+/**
+ * A cache whose geometry is fixed at compile time. Behaves as a non-inclusive `Cache' with the
+ * same geometry, but address decomposition folds to constant shifts and masks, the way loops have
+ * constant bounds, and accesses skip bounds checks and type-erased handlers.
+ * @param The number of bits required to specify a set.
+ * @param The number of bits required to specify a way within a set.
+ */
+template <unsigned int SetBits, unsigned int WayBits> class FixedCache : public Storage
+{
+	static_assert(SetBits + WayBits + LINE_SPEC <= MEM_WORD_SPEC, "cache larger than memory");
+
+	static constexpr int WAYS = 1 << WayBits;
+	static constexpr int LINES = 1 << (SetBits + WayBits);
+	static constexpr int TAG_SHIFT = SetBits + LINE_SPEC;
+	static constexpr int SET_MASK = (1 << SetBits) - 1;
+	static constexpr int OFFSET_MASK = (1 << LINE_SPEC) - 1;
+	static constexpr int ADDRESS_MASK = (1 << MEM_WORD_SPEC) - 1;
+
+  public:
+	/**
+	 * Constructor.
+	 * @param The next lowest level in storage. Methods from this object are
+	 * called in case of a cache miss.
+	 * @param The number of clock cycles each access takes.
+	 * @return A new cache object.
+	 */
+	FixedCache(Storage *lower, int delay) : Storage(delay)
+	{
+		this->data->resize(LINES);
+		this->meta.fill({-1, -1, -1});
+		this->lower = lower;
+		this->access_num = 0;
+		this->missed = 0;
+		this->maintaining = 0;
+		this->lower->add_upper(this);
+	}
+
+	~FixedCache()
+	{
+		if (this->owns_lower)
+			delete this->lower;
+		delete this->data;
+	}
+
+	int
+	write_word(void *id, signed int data, int address) override
+	{
+		return this->access(id, address, [&](int index, int offset) {
+			(*this->data)[index][offset] = data;
+			this->meta[index][1] = 1;
+		});
+	}
+
+	int
+	write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address) override
+	{
+		return this->access(id, address, [&](int index, int) {
+			(*this->data)[index] = data_line;
+			this->meta[index][1] = 1;
+		});
+	}
+
+	int
+	read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line) override
+	{
+		return this->access(
+			id, address, [&](int index, int) { data_line = (*this->data)[index]; });
+	}
+
+	int
+	write_words(
+		void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask) override
+	{
+		return this->access(id, address, [&](int index, int) {
+			for (int i = 0; i < LINE_SIZE; ++i)
+				if (mask >> i & 1)
+					(*this->data)[index][i] = data_line[i];
+			this->meta[index][1] = 1;
+		});
+	}
+
+	int
+	read_words(
+		void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line) override
+	{
+		return this->access(id, address, [&](int index, int) {
+			for (int i = 0; i < LINE_SIZE; ++i)
+				if (mask >> i & 1)
+					data_line[i] = (*this->data)[index][i];
+		});
+	}
+
+	int
+	read_word(void *id, int address, signed int &data) override
+	{
+		return this->access(
+			id, address, [&](int index, int offset) { data = (*this->data)[index][offset]; });
+	}
+
+	int
+	back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line) override
+	{
+		int r, index;
+
+		r = this->invalidate_uppers(address, data_line);
+		index = this->search_ways_for(address);
+		if (this->meta[index][0] == (address & ADDRESS_MASK) >> TAG_SHIFT) {
+			if (r < 2 && this->meta[index][1] >= 0) {
+				data_line = (*this->data)[index];
+				r = 2;
+			}
+			r = std::max(r, 1);
+			this->meta[index] = {-1, -1, -1};
+		}
+
+		return r;
+	}
+
+	/**
+	 * See `Cache::maintain'. Every line is scanned, rather than looked up.
+	 */
+	int
+	maintain(void *id, enum Maintenance op, int start, int end) override
+	{
+		int index, address;
+		std::array<signed int, 3> *meta;
+
+		if (!this->preprocess(id, start))
+			return 0;
+
+		++this->stats[MAINTENANCE_CYCLES];
+		if (!this->maintaining) {
+			this->maintaining = 1;
+			for (index = 0; index < LINES; ++index) {
+				meta = &this->meta[index];
+				address = ((*meta)[0] << TAG_SHIFT) | ((index / WAYS) << LINE_SPEC);
+				if ((*meta)[0] < 0 || address + LINE_SIZE <= start || address >= end)
+					continue;
+				this->batch.push_back(index);
+				if (op != INVALIDATE && (*meta)[1] >= 0)
+					this->burst.push_back({address, (1U << LINE_SIZE) - 1, (*this->data)[index]});
+			}
+		}
+
+		if (!this->burst.empty()) {
+			if (!this->lower->write_lines(this, this->burst))
+				return 0;
+			for (const LineWrite &l : this->burst)
+				TRACE(WRITEBACK, l.address);
+			this->stats[WRITEBACKS] += this->burst.size();
+			this->burst.clear();
+			for (int t : this->batch)
+				this->meta[t][1] = -1;
+		}
+
+		if (op != CLEAN)
+			for (int t : this->batch)
+				this->meta[t] = {-1, -1, -1};
+		this->batch.clear();
+
+		if (this->maintaining == 1) {
+			if (!this->lower->maintain(this, op, start, end))
+				return 0;
+			this->maintaining = 2;
+		}
+		if (!this->is_data_ready())
+			return 0;
+
+		this->maintaining = 0;
+		return 1;
+	}
+
+  private:
+	int
+	process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+		override
+	{
+		return this->access(id, address, request_handler);
+	}
+
+	/**
+	 * Performs the same steps as `Cache::process', calling `request_handler' directly.
+	 */
+	template <typename F>
+	inline int
+	access(void *id, int address, F &&request_handler)
+	{
+		int index;
+		std::array<signed int, 3> *meta;
+
+		address &= ADDRESS_MASK;
+		if (!this->preprocess(id, address) || this->priming_address(address) ||
+			!this->is_data_ready())
+			return 0;
+
+		index = this->search_ways_for(address);
+		request_handler(index, address & OFFSET_MASK);
+		// set usage status
+		meta = &this->meta[index];
+		(*meta)[2] = this->access_num % INT_MAX;
+		++this->access_num;
+		if (this->missed)
+			++this->stats[MISSES];
+		else {
+			TRACE(HIT, address);
+			++this->stats[HITS];
+		}
+		this->missed = 0;
+
+		return 1;
+	}
+
+	/**
+	 * Helper for access. See `Cache::priming_address'.
+	 */
+	inline int
+	priming_address(int address)
+	{
+		int tag, index, victim;
+		std::array<signed int, 3> *meta;
+		std::array<signed int, LINE_SIZE> *evict;
+
+		tag = address >> TAG_SHIFT;
+		index = this->search_ways_for(address);
+		meta = &this->meta[index];
+		if ((*meta)[0] == tag)
+			return 0;
+
+		evict = &(*this->data)[index];
+		victim = ((*meta)[0] << TAG_SHIFT) | (address & (SET_MASK << LINE_SPEC));
+		if (!this->missed) {
+			this->missed = 1;
+			TRACE(MISS, address);
+			if ((*meta)[0] >= 0) {
+				TRACE(EVICT, victim);
+				++this->stats[EVICTIONS];
+			}
+		}
+
+		if ((*meta)[1] >= 0 || ((*meta)[0] >= 0 && this->lower->get_inclusion() == EXCLUSIVE)) {
+			if (this->lower->write_victim(this, *evict, victim, (*meta)[1] >= 0)) {
+				*meta = {-1, -1, -1};
+				TRACE(WRITEBACK, victim);
+				++this->stats[WRITEBACKS];
+			}
+		} else if (this->lower->read_line(this, address, *evict))
+			(*meta)[0] = tag;
+
+		return 1;
+	}
+
+	/**
+	 * Searches the set `address' maps to for its tag. See `Cache::search_ways_for'.
+	 * @param the address to search for
+	 * @return the true index if the tag is present, or the index to be replaced if not.
+	 */
+	inline int
+	search_ways_for(int address)
+	{
+		int i, tag, set, r;
+
+		tag = address >> TAG_SHIFT;
+		set = ((address >> LINE_SPEC) & SET_MASK) * WAYS;
+		for (i = 0; i < WAYS; ++i)
+			if (this->meta[set + i][0] == tag)
+				return set + i;
+
+		r = set;
+		for (i = 1; i < WAYS; ++i)
+			if (this->meta[set + i][2] < this->meta[r][2])
+				r = set + i;
+		return r;
+	}
+
+	/**
+	 * The current access number. Used to assign usage data for the LRU replacement policy.
+	 */
+	unsigned int access_num;
+	/**
+	 * Nonzero if the current request missed. Set on the first cycle the miss is seen.
+	 */
+	int missed;
+	/**
+	 * 1 while a maintenance operation is in progress, 2 once `lower' has completed it, 0 otherwise.
+	 */
+	int maintaining;
+	/**
+	 * The lines the current maintenance operation applies to, and the dirty lines it is writing
+	 * back.
+	 */
+	std::vector<int> batch;
+	std::vector<LineWrite> burst;
+	/**
+	 * Metadata about elements in `data', laid out as in `Cache'.
+	 */
+	std::array<std::array<signed int, 3>, LINES> meta;
+};
+
+#endif /* FIXED_CACHE_H_INCLUDED */
@@ -0,0 +1,100 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ICACHE_H
+#define ICACHE_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+/**
+ * A read-only cache for instruction fetch. Lines are never dirty, so each keeps only a tag and
+ * its usage data, and evictions are silent unless `lower' is EXCLUSIVE. Timing is the same as a
+ * non-inclusive `Cache' of the same geometry.
+ */
+class ICache : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * @param The next lowest level in storage, which lines are fetched from.
+	 * @param The number of bits required to specify a line in this cache.
+	 * @param The number of bits required to specify a way within a set.
+	 * @param The number of clock cycles each access takes.
+	 * @return A new, empty instruction cache.
+	 */
+	ICache(Storage *lower, unsigned int size, unsigned int ways, int delay);
+	~ICache();
+
+	/**
+	 * Instruction caches are read-only. Throws std::invalid_argument.
+	 */
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word(void *, int, signed int &) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int back_invalidate(int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * Drops the lines in range unless `op' is CLEAN, then performs `op' below this level.
+	 */
+	int maintain(void *, enum Maintenance, int, int) override;
+	/**
+	 * @param the index of an element in `this->data'
+	 * @return the tag held there, or -1 if it is invalid
+	 */
+	int get_tag(int index) const;
+
+  private:
+	int process(
+		void *id, int address, std::function<void(int index, int offset)> request_handler) override;
+	/**
+	 * Helper for process. See `Cache::priming_address'.
+	 * @param the address that must be present in cache.
+	 * @return 0 if the address is currently in cache, 1 if it is being fetched.
+	 */
+	int priming_address(int address);
+	/**
+	 * See `Cache::search_ways_for'.
+	 * @param the address to search for
+	 * @return the true index if the tag is present, or the index to be replaced if not.
+	 */
+	int search_ways_for(int address) const;
+	/**
+	 * The number of bits required to specify a line, and a way within a set.
+	 */
+	unsigned int size;
+	unsigned int ways;
+	/**
+	 * The current access number. Used to assign usage data for the LRU replacement policy.
+	 */
+	unsigned int access_num;
+	/**
+	 * Nonzero if the current request missed. Set on the first cycle the miss is seen.
+	 */
+	int missed;
+	/**
+	 * The tag of each element in `data', or -1 if it is invalid, and its last access number.
+	 */
+	std::vector<int> tags;
+	std::vector<unsigned int> used;
+};
+
+#endif /* ICACHE_H_INCLUDED */
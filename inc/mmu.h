@@ -0,0 +1,178 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MMU_H
+#define MMU_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <functional>
+#include <vector>
+
+/**
+ * A page table entry. The physical page number is stored above a valid bit.
+ */
+#define PTE_VALID(p) ((p) & 1)
+#define PTE_PAGE(p) ((p) >> 1)
+#define MAKE_PTE(page) (((page) << 1) | 1)
+
+class Tlb
+{
+  public:
+	/**
+	 * Constructor.
+	 * @param The number of bits required to specify an entry.
+	 * @param The number of bits required to specify a way within a set.
+	 * @param The number of clock cycles each lookup takes.
+	 * @return A new, empty TLB.
+	 */
+	Tlb(unsigned int size, unsigned int ways, int delay);
+
+	/**
+	 * @param a virtual page number
+	 * @return the physical page `vpn' maps to, or -1 if it is not cached
+	 */
+	int lookup(int vpn);
+	/**
+	 * Caches a translation, replacing the least recently used entry in its set.
+	 * @param a virtual page number
+	 * @param the physical page it maps to
+	 */
+	void insert(int vpn, int ppn);
+	/**
+	 * Drops every cached translation.
+	 */
+	void flush();
+	/**
+	 * @return the number of clock cycles each lookup takes
+	 */
+	int get_delay() const;
+
+  private:
+	/**
+	 * Helper for lookup and insert. See `Cache::search_ways_for'.
+	 */
+	int search_ways_for(int vpn);
+	/**
+	 * The number of bits required to specify an entry, and a way within a set.
+	 */
+	unsigned int size;
+	unsigned int ways;
+	int delay;
+	/**
+	 * The current access number. Used to assign usage data for the LRU replacement policy.
+	 */
+	unsigned int access_num;
+	/**
+	 * The virtual page, physical page, and last access number of each entry. Entries with a
+	 * negative virtual page are invalid.
+	 */
+	std::vector<std::array<signed int, 3>> entries;
+};
+
+class Mmu : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * Page tables are radix trees of `levels' levels held in physical memory. Each table is
+	 * indexed by `level_spec' bits of the virtual page number, most significant first, and
+	 * holds one page table entry per word. Interior entries hold the physical page of the next
+	 * table.
+	 * @param The physical memory hierarchy. Page table walks are read through it.
+	 * @param The first level TLB.
+	 * @param The second level TLB, or nullptr.
+	 * @param The number of bits required to specify a word in a page.
+	 * @param The number of bits of the virtual page number used to index each table.
+	 * @param The number of levels of page tables.
+	 * @param The physical address of the root page table.
+	 * @return A new memory management unit.
+	 */
+	Mmu(Storage *lower,
+		Tlb *l1,
+		Tlb *l2,
+		unsigned int page_spec,
+		unsigned int level_spec,
+		unsigned int levels,
+		int root);
+	~Mmu();
+
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word(void *, int, signed int &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word_non_temporal(void *, int, signed int &) override;
+	int write_word_non_temporal(void *, signed int, int) override;
+	/**
+	 * Passes the prefetch down if the first level TLB holds its translation, and drops it
+	 * otherwise, rather than walking the page tables for it.
+	 */
+	int prefetch(void *, int, int) override;
+	/**
+	 * Drops every cached translation.
+	 */
+	void flush_tlbs();
+
+  private:
+	/**
+	 * Translates `address', then calls `request_handler' with the physical address every cycle
+	 * until it sets `served'. Throws std::out_of_range if `address' is not mapped.
+	 */
+	int process(
+		void *id, int address, std::function<void(int index, int offset)> request_handler) override;
+	/**
+	 * Helper for process. Advances the translation of `address' by one cycle.
+	 * @param a virtual address
+	 * @param set to the physical address once translation completes
+	 * @return 1 if translation is complete, 0 otherwise
+	 */
+	int translate(int address, int &paddr);
+	/**
+	 * The step of translation the current request is in.
+	 */
+	enum { TLB_IDLE, TLB_L1, TLB_L2, TLB_WALK, TLB_DONE } phase;
+	/**
+	 * The first and second level TLBs.
+	 */
+	Tlb *l1;
+	Tlb *l2;
+	unsigned int page_spec;
+	unsigned int level_spec;
+	unsigned int levels;
+	int root;
+	/**
+	 * Cycles left in the current TLB lookup.
+	 */
+	int countdown;
+	/**
+	 * The table level and physical address of the table the walker is reading.
+	 */
+	unsigned int walk_level;
+	int walk_table;
+	/**
+	 * The physical page the current request translated to.
+	 */
+	int ppn;
+	/**
+	 * Set by request handlers once `lower' completes the physical access.
+	 */
+	int served;
+};
+
+#endif /* MMU_H_INCLUDED */
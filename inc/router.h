@@ -0,0 +1,84 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ROUTER_H
+#define ROUTER_H
+#include "definitions.h"
+#include "scratchpad.h"
+#include "storage.h"
+#include <array>
+#include <functional>
+
+class Router : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * Sends requests for addresses held by `scratchpad' to it, and all others to `lower'. Requests
+	 * are forwarded under the requester's id the cycle they are made, so the router adds no
+	 * latency, and a request to one side never waits on a request to the other. Several routers
+	 * may share a scratchpad, such as one in front of the caches for compute and one in front of
+	 * memory for a `Dma' engine to fill and drain it. The caller remains responsible for deleting
+	 * `scratchpad'.
+	 * @param The level of storage requests outside the scratchpad are forwarded to.
+	 * @param The scratchpad.
+	 * @return A new router.
+	 */
+	Router(Storage *lower, Scratchpad *scratchpad);
+	~Router();
+
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word(void *, int, signed int &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int write_victim(void *, std::array<signed int, LINE_SIZE>, int, int) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word_non_temporal(void *, int, signed int &) override;
+	int read_words_non_temporal(
+		void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	int write_word_non_temporal(void *, signed int, int) override;
+	int back_invalidate(int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * Prefetches outside the scratchpad are passed to `lower'. Those within it are dropped.
+	 */
+	int prefetch(void *, int, int) override;
+	/**
+	 * Waits for every request in flight in `scratchpad', and at `lower' and below it.
+	 */
+	int fence(void *) override;
+	/**
+	 * @return the inclusion policy of `lower'
+	 */
+	enum Inclusion get_inclusion() const override;
+
+  private:
+	/**
+	 * Calls `request_handler' with the address, as requests are forwarded whole by the access
+	 * methods rather than held here.
+	 */
+	int process(
+		void *id, int address, std::function<void(int index, int offset)> request_handler) override;
+	/**
+	 * @param an address
+	 * @return the level requests for `address' are forwarded to
+	 */
+	Storage *route(int address) const;
+	Scratchpad *scratchpad;
+};
+
+#endif /* ROUTER_H_INCLUDED */
@@ -0,0 +1,251 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+#include "definitions.h"
+#include "storage.h"
+#include "tracer.h"
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Drives requesters written as coroutines. A requester is a function returning
+ * `Scheduler::Task' which awaits accesses made through the scheduler:
+ *
+ *	Scheduler::Task
+ *	core(Scheduler &s, Storage &l1)
+ *	{
+ *		signed int w = co_await s.read_word(l1, 0x40);
+ *		co_await s.write_word(l1, w + 1, 0x40);
+ *	}
+ *
+ * Each task is a separate requester. Every cycle, the scheduler presents each outstanding
+ * access to its level once, and resumes the task the cycle its access completes. The task's
+ * next access is presented from the following cycle, as though it had been issued by hand.
+ */
+class Scheduler
+{
+  public:
+	/**
+	 * A requester owned by a scheduler once spawned.
+	 */
+	class Task
+	{
+	  public:
+		struct promise_type {
+			Task get_return_object();
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { throw; }
+			/**
+			 * The position of this task in `Scheduler::tasks'.
+			 */
+			size_t slot;
+		};
+
+		Task(Task &&other) noexcept;
+		Task(const Task &) = delete;
+		Task &operator=(const Task &) = delete;
+		~Task();
+
+	  private:
+		friend class Scheduler;
+		explicit Task(std::coroutine_handle<promise_type> handle);
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	/**
+	 * An access awaited by a task, presented to its level once per cycle until it completes.
+	 */
+	class Access
+	{
+	  public:
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+
+	  protected:
+		Access(Scheduler *scheduler, Storage *storage, int address);
+		virtual ~Access() = default;
+		/**
+		 * Presents the access to its level for one cycle.
+		 * @param the requester making the access
+		 * @return 1 if the access completed, 0 otherwise
+		 */
+		virtual int attempt(void *id) = 0;
+		Scheduler *scheduler;
+		Storage *storage;
+		int address;
+
+	  private:
+		friend class Scheduler;
+	};
+
+	class WordRead : public Access
+	{
+	  public:
+		WordRead(Scheduler *scheduler, Storage *storage, int address);
+		signed int await_resume() const { return this->word; }
+
+	  private:
+		int attempt(void *id) override;
+		signed int word;
+	};
+
+	class LineRead : public Access
+	{
+	  public:
+		LineRead(Scheduler *scheduler, Storage *storage, int address);
+		std::array<signed int, LINE_SIZE> await_resume() const { return this->line; }
+
+	  private:
+		int attempt(void *id) override;
+		std::array<signed int, LINE_SIZE> line;
+	};
+
+	class WordWrite : public Access
+	{
+	  public:
+		WordWrite(Scheduler *scheduler, Storage *storage, signed int word, int address);
+		void await_resume() const {}
+
+	  private:
+		int attempt(void *id) override;
+		signed int word;
+	};
+
+	class LineWrite : public Access
+	{
+	  public:
+		LineWrite(
+			Scheduler *scheduler,
+			Storage *storage,
+			std::array<signed int, LINE_SIZE> line,
+			int address);
+		void await_resume() const {}
+
+	  private:
+		int attempt(void *id) override;
+		std::array<signed int, LINE_SIZE> line;
+	};
+
+	class Sleep : public Access
+	{
+	  public:
+		Sleep(Scheduler *scheduler, int cycles);
+		void await_resume() const {}
+
+	  private:
+		int attempt(void *id) override;
+		int remaining;
+	};
+
+	/**
+	 * Constructor.
+	 * @return A new scheduler with no tasks, at cycle 0.
+	 */
+	Scheduler();
+	~Scheduler();
+
+	/**
+	 * @param the level to access
+	 * @param the address to read
+	 * @return an access which resumes with the word read
+	 */
+	WordRead read_word(Storage &storage, int address);
+	/**
+	 * @param the level to access
+	 * @param the address to read
+	 * @return an access which resumes with the line read
+	 */
+	LineRead read_line(Storage &storage, int address);
+	/**
+	 * @param the level to access
+	 * @param the word to write
+	 * @param the address to write to
+	 * @return an access which resumes once the word is written
+	 */
+	WordWrite write_word(Storage &storage, signed int data, int address);
+	/**
+	 * @param the level to access
+	 * @param the line to write
+	 * @param the address to write to
+	 * @return an access which resumes once the line is written
+	 */
+	LineWrite write_line(Storage &storage, std::array<signed int, LINE_SIZE> data_line, int address);
+	/**
+	 * @param the number of cycles to wait, at least 1
+	 * @return an access which resumes after `cycles' cycles
+	 */
+	Sleep sleep(int cycles);
+
+	/**
+	 * Takes ownership of `task'. It starts on the next cycle run.
+	 * @param the task
+	 */
+	void spawn(Task task);
+	/**
+	 * Runs cycles until every task has returned. Exceptions thrown by a task propagate out of
+	 * this call, after which the scheduler may only be destroyed.
+	 * @return the number of cycles run
+	 */
+	unsigned long run();
+	/**
+	 * @return the number of cycles run so far
+	 */
+	unsigned long now() const;
+	/**
+	 * Ticks `storage' at the end of every cycle run, so that work it does in the background
+	 * advances. Only the highest level of a hierarchy need be attached.
+	 * @param the level to tick
+	 */
+	void attach(Storage &storage);
+	/**
+	 * Advances `tracer' with every cycle run.
+	 * @param the tracer, or nullptr
+	 */
+	void set_tracer(Tracer *tracer);
+
+  private:
+	/**
+	 * Resumes `handle', releasing its task if it returns.
+	 * @param a spawned task
+	 */
+	void resume(std::coroutine_handle<> handle);
+	/**
+	 * Every task spawned which has not returned, and the tasks which have not yet started.
+	 */
+	std::vector<std::coroutine_handle<Task::promise_type>> tasks;
+	std::vector<std::coroutine_handle<Task::promise_type>> starting;
+	/**
+	 * The accesses being presented each cycle, and those issued this cycle, with the tasks
+	 * awaiting them.
+	 */
+	std::vector<std::pair<Access *, std::coroutine_handle<>>> pending;
+	std::vector<std::pair<Access *, std::coroutine_handle<>>> issued;
+	unsigned long cycle;
+	Tracer *tracer;
+	/**
+	 * The levels ticked every cycle.
+	 */
+	std::vector<Storage *> clocked;
+};
+
+#endif /* SCHEDULER_H_INCLUDED */
@@ -0,0 +1,66 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SCRATCHPAD_H
+#define SCRATCHPAD_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <functional>
+
+class Scratchpad : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * A software-managed memory holding the addresses [`base', `base' + `lines' * LINE_SIZE).
+	 * There are no tags, so every access takes `delay' cycles. Throws std::invalid_argument if
+	 * `base' is not the first word of a line, or the range does not lie within memory.
+	 * @param The first address held.
+	 * @param The number of lines held.
+	 * @param The number of clock cycles each access takes.
+	 * @return A new, zeroed scratchpad.
+	 */
+	Scratchpad(int base, int lines, int delay);
+	~Scratchpad();
+
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int read_word(void *, int, signed int &) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * @param an address
+	 * @return 1 if `address' is held by this scratchpad, 0 otherwise
+	 */
+	int contains(int address) const;
+
+  private:
+	/**
+	 * Throws std::out_of_range if `address' is not held, then calls `request_handler' with the
+	 * line and word it is in once the access has taken `delay' cycles.
+	 */
+	int process(
+		void *id, int address, std::function<void(int line, int word)> request_handler) override;
+	/**
+	 * The first address held.
+	 */
+	int base;
+};
+
+#endif /* SCRATCHPAD_H_INCLUDED */
@@ -18,6 +18,7 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 #include "definitions.h"
+#include "tracer.h"
 #include <algorithm>
 #include <array>
 #include <functional>
@@ -33,6 +34,135 @@
   ((a < 0) ? ((a % MEM_WORDS) + MEM_WORDS) % MEM_WORDS : a % MEM_WORDS)
 // clang-format on
 
+/**
+ * The relationship a level of storage keeps with the contents of the levels above it.
+ * NON_INCLUSIVE levels make no guarantees. INCLUSIVE levels hold a superset of the levels above
+ * them, and back-invalidate those levels on eviction. EXCLUSIVE levels never duplicate a line held
+ * above them: hits are handed to the requester and dropped, misses bypass this level, and upper
+ * levels swap every valid victim into it.
+ */
+enum Inclusion { NON_INCLUSIVE, INCLUSIVE, EXCLUSIVE };
+
+/**
+ * Cache maintenance operations. CLEAN writes dirty lines back and keeps them, INVALIDATE drops
+ * lines without writing them back, and FLUSH writes dirty lines back and drops them.
+ */
+enum Maintenance { CLEAN, INVALIDATE, FLUSH };
+
+/**
+ * How a free level of storage chooses among the requesters waiting for it. FIRST_COME grants it
+ * to whichever requester asks first. ROUND_ROBIN grants it to the next waiting requester after
+ * the one last granted, in the order requesters were first seen. PRIORITY grants it to the
+ * waiting requester with the highest priority, oldest first. OLDEST grants it to the requester
+ * which has waited longest.
+ */
+enum Arbitration { FIRST_COME, ROUND_ROBIN, PRIORITY, OLDEST };
+
+/**
+ * Event counters kept by each level of storage.
+ */
+enum Stat {
+	HITS,
+	MISSES,
+	EVICTIONS,
+	WRITEBACKS,
+	BACK_INVALIDATIONS,
+	LOADS,
+	LOAD_CYCLES,
+	EARLY_RESTARTS,
+	STREAM_STALLS,
+	TLB_L1_MISSES,
+	TLB_L2_MISSES,
+	WALKS,
+	WALK_CYCLES,
+	COMPRESSED_BYTES,
+	UNCOMPRESSED_BYTES,
+	DECOMPRESSION_CYCLES,
+	MAINTENANCE_CYCLES,
+	PREDICTED_WAYS,
+	MISPREDICTED_WAYS,
+	BUS_BUSY_CYCLES,
+	QUEUE_CYCLES,
+	QUEUE_FULL,
+	STORE_STALLS,
+	STORE_MERGES,
+	STORE_FORWARDS,
+	COMPULSORY_MISSES,
+	CAPACITY_MISSES,
+	CONFLICT_MISSES,
+	SECTOR_MISSES,
+	FILL_WORDS_SAVED,
+	WRITEBACK_WORDS_SAVED,
+	PREFETCHES,
+	USEFUL_PREFETCHES,
+	USELESS_PREFETCHES,
+	BYPASSES,
+	REQUESTS,
+	LATENCY_CYCLES,
+	LOWER_CYCLES,
+	STAT_COUNT
+};
+
+/**
+ * The number of buckets in a latency histogram. Bucket 0 counts requests taking no cycles, and
+ * bucket b counts those taking [2^(b - 1), 2^b) cycles. The last bucket also counts any longer.
+ */
+#define LATENCY_BUCKETS 32
+
+/**
+ * The clock cycles a request spent at each level it reached, indexed by depth below the level
+ * it was issued to.
+ */
+struct Ledger {
+	/**
+	 * The depth of the deepest level which served the request.
+	 */
+	int hit_level;
+	/**
+	 * The cycles each level spent serving the request, including the cycles it waited on the
+	 * levels below it, and the cycles it refused the request while serving others.
+	 */
+	std::vector<unsigned long> service;
+	std::vector<unsigned long> contention;
+};
+
+/**
+ * A line written as part of a burst by `Storage::write_lines'.
+ */
+struct LineWrite {
+	/**
+	 * An address within the line, the words to write, bit i for word i, and the data.
+	 */
+	int address;
+	unsigned int mask;
+	std::array<signed int, LINE_SIZE> data;
+};
+
+/**
+ * A non-owning, read-only view of consecutive lines of a level of storage. Invalidated by
+ * anything which resizes that level.
+ */
+class LineView
+{
+  public:
+	/**
+	 * Constructor.
+	 * @param The first line in the view.
+	 * @param The number of lines in the view.
+	 * @return A view of the lines.
+	 */
+	LineView(const std::array<signed int, LINE_SIZE> *first, size_t count);
+
+	const std::array<signed int, LINE_SIZE> *begin() const;
+	const std::array<signed int, LINE_SIZE> *end() const;
+	size_t size() const;
+	const std::array<signed int, LINE_SIZE> &operator[](size_t i) const;
+
+  private:
+	const std::array<signed int, LINE_SIZE> *first;
+	size_t count;
+};
+
 class Storage
 {
   public:
@@ -53,6 +183,16 @@ class Storage
 	 */
 	virtual int write_word(void *id, signed int data, int address) = 0;
 	virtual int write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address) = 0;
+	/**
+	 * Write the words of `data_line' selected by `mask' into the line containing `address'.
+	 * @param the source making the request.
+	 * @param the data to write, indexed by word.
+	 * @param an address within the line to write to.
+	 * @param the words to write, bit i for word i.
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	virtual int write_words(
+		void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask) = 0;
 
 	/**
 	 * Get the data line at `address`.
@@ -63,11 +203,226 @@ class Storage
 	 */
 	virtual int read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data) = 0;
 	virtual int read_word(void *id, int address, signed int &data) = 0;
+	/**
+	 * Get the words selected by `mask' of the line containing `address'. The other words of
+	 * `data' are left unchanged.
+	 * @param the source making the request.
+	 * @param an address within the line being accessed.
+	 * @param the words to read, bit i for word i.
+	 * @param the data being returned
+	 * @return 1 if the request was completed, 0 otherwise
+	 */
+	virtual int
+	read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data) = 0;
+	/**
+	 * Writes each of `lines' as one burst. By default the lines are written one after another,
+	 * each issued the cycle the previous completes. Levels which can pipeline a burst override
+	 * this. `lines' must not change until the burst completes.
+	 * @param the source making the request.
+	 * @param the lines to write, in order.
+	 * @return 1 if every line has been written, 0 otherwise.
+	 */
+	virtual int write_lines(void *id, const std::vector<LineWrite> &lines);
+	/**
+	 * Hands this level a line evicted from the level above, for levels which are exclusive of the
+	 * levels above them. Such a level places the line without reading it from the level below, and
+	 * keeps it clean unless `dirty'. Other levels only write dirty lines back.
+	 * @param the source making the request.
+	 * @param the evicted line.
+	 * @param an address within the evicted line.
+	 * @param nonzero if the evicted line was dirty.
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	virtual int
+	write_victim(void *id, std::array<signed int, LINE_SIZE> data_line, int address, int dirty);
+
+	/**
+	 * Drops any copy of the line containing `address' held by this level or the levels above it.
+	 * A sectored copy only overwrites the words it holds, so the caller should pass in the line as
+	 * the level below holds it.
+	 * @param an address within the line to drop
+	 * @param updated to the most recent contents of the line, if a dropped copy was dirty
+	 * @return 0 if no copy was held, 1 if only clean copies were dropped, 2 if a dirty copy was
+	 * dropped and written into the second argument.
+	 */
+	virtual int back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line);
+
+	/**
+	 * Performs `op' on the lines containing addresses in [`start', `end') at this level, then at
+	 * every level below it. Dirty lines are collected up front and written back to the level below
+	 * as one burst with `write_lines'.
+	 * @param the source making the request.
+	 * @param the operation
+	 * @param the first address in the range
+	 * @param the address after the last in the range
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	virtual int maintain(void *id, enum Maintenance op, int start, int end);
+	/**
+	 * Requests that the line containing `address' be filled into a cache at or below this level,
+	 * without waiting for it. The fill proceeds in the background as `tick' is called, and is
+	 * dropped if the line is already held. Levels which are not caches pass the request down.
+	 * @param the source making the request.
+	 * @param an address within the line to fill.
+	 * @param the number of caches to pass the request down through, 0 to fill the first.
+	 * @return 1 if the prefetch was accepted or dropped, 0 if it must be retried.
+	 */
+	virtual int prefetch(void *id, int address, int level);
+	/**
+	 * Like `read_word', but hints that the line will not be reused soon. Caches do not promote
+	 * lines on these accesses, and insert lines filled for them at the LRU position.
+	 * @param the source making the request.
+	 * @param the address being accessed.
+	 * @param the data being returned
+	 * @return 1 if the request was completed, 0 otherwise
+	 */
+	virtual int read_word_non_temporal(void *id, int address, signed int &data);
+	/**
+	 * Like `read_words', with the hint of `read_word_non_temporal'. Caches pass the hint down
+	 * with the fills they make for non-temporal accesses.
+	 * @param the source making the request.
+	 * @param an address within the line being accessed.
+	 * @param the words to read, bit i for word i.
+	 * @param the data being returned
+	 * @return 1 if the request was completed, 0 otherwise
+	 */
+	virtual int read_words_non_temporal(
+		void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data);
+	/**
+	 * Like `write_word', but hints that the line will not be reused soon. Caches which do not
+	 * hold the line write the word through to the level below without allocating it.
+	 * @param the source making the request.
+	 * @param the data (hexadecimal) to write.
+	 * @param the address to write to.
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	virtual int write_word_non_temporal(void *id, signed int data, int address);
+	/**
+	 * Waits for every request in flight at this level and below it to complete.
+	 * @param the source making the request.
+	 * @return 1 if no requests are in flight, 0 otherwise.
+	 */
+	virtual int fence(void *id);
+	/**
+	 * Advances work this level does in the background by one clock cycle, then does the same for
+	 * the levels below it which it owns. Should be called on the highest level once per cycle.
+	 */
+	virtual void tick();
+	/**
+	 * Writes back and drops every line at this level and below it.
+	 * @param the source making the request.
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	int flush(void *id);
+	/**
+	 * Writes back dirty lines in [`start', `end') at this level and below it.
+	 * @param the source making the request.
+	 * @param the first address in the range
+	 * @param the address after the last in the range
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	int clean(void *id, int start, int end);
+	/**
+	 * Drops lines in [`start', `end') at this level and below it, discarding dirty data.
+	 * @param the source making the request.
+	 * @param the first address in the range
+	 * @param the address after the last in the range
+	 * @return 1 if the request was completed, 0 otherwise.
+	 */
+	int invalidate(void *id, int start, int end);
+
+	/**
+	 * Back-invalidates the line containing `address' in every level above this one.
+	 * @param an address within the line to drop
+	 * @param set to the most recent contents of the line, if a dropped copy was dirty
+	 * @return the greatest value returned by `back_invalidate' on the levels above
+	 */
+	int invalidate_uppers(int address, std::array<signed int, LINE_SIZE> &data_line);
 
 	/**
 	 * @return a copy of `this->data'
 	 */
 	std::vector<std::array<signed int, LINE_SIZE>> get_data() const;
+	/**
+	 * @param the index of a line in `this->data'
+	 * @return a read-only reference to that line, without copying it
+	 */
+	const std::array<signed int, LINE_SIZE> &view_line(int index) const;
+	/**
+	 * @param the index of the first line in `this->data'
+	 * @param the number of lines
+	 * @return a read-only view of those lines, without copying them
+	 */
+	LineView view_lines(int first, int count) const;
+	/**
+	 * Registers `upper' as a level which is filled from this one.
+	 * @param the level directly above this one
+	 */
+	void add_upper(Storage *upper);
+	/**
+	 * @return the level directly below this one, or nullptr
+	 */
+	Storage *get_lower() const;
+	/**
+	 * Stops this level deleting `lower' when it is deleted, so that several levels may fill from
+	 * it. The caller becomes responsible for deleting it.
+	 */
+	void share_lower();
+	/**
+	 * @return the inclusion policy this level keeps with respect to the levels above it
+	 */
+	virtual enum Inclusion get_inclusion() const;
+	/**
+	 * Reports this level's events to `tracer'.
+	 * @param the tracer to report to, or nullptr to stop tracing
+	 * @param the name this level is exported under
+	 */
+	void set_tracer(Tracer *tracer, const char *name);
+	/**
+	 * Sets how this level chooses among waiting requesters. Requesters which are refused must
+	 * keep asking until they are granted this level.
+	 * @param the policy
+	 * @param the number of requesters which may wait in order, or 0 for no limit. Requesters
+	 * asking while the queue is full are refused without joining it.
+	 */
+	void set_arbitration(enum Arbitration policy, unsigned int depth);
+	/**
+	 * Sets the priority of `id' under the PRIORITY policy. Requesters default to 0.
+	 * @param the requester
+	 * @param the new priority, higher first
+	 */
+	void set_priority(void *id, int priority);
+	/**
+	 * @param a requester
+	 * @return the number of cycles `id' has been refused this level
+	 */
+	unsigned long get_wait_cycles(void *id) const;
+	/**
+	 * @return the ledger of the last request this level completed, with the ledgers of the
+	 * requests it made of the levels below merged in
+	 */
+	const Ledger &get_ledger() const;
+	/**
+	 * @return the number of requests completed by this level with each latency, counting the
+	 * cycles they were refused, in log-scale buckets
+	 */
+	const std::array<unsigned long, LATENCY_BUCKETS> &get_latency_histogram() const;
+	/**
+	 * @param a fraction of the requests completed, from 0 to 1
+	 * @return the latency that fraction of requests completed within, rounded up to the end of
+	 * its histogram bucket, or 0 if no requests have completed
+	 */
+	unsigned long get_latency_percentile(double fraction) const;
+	/**
+	 * @param the counter to read
+	 * @return the value of the counter `s'
+	 */
+	unsigned long get_stat(enum Stat s) const;
+	/**
+	 * @param a counter
+	 * @return a printable name for `s'
+	 */
+	static const char *stat_name(enum Stat s);
 
   protected:
 	/**
@@ -84,9 +439,35 @@ class Storage
 	/**
 	 * Helper for process. Given `id`, returns 0 if the request should trivially be ignored.
 	 * @param the source making the request
+	 * @param the address being accessed
 	 * @return 0 if the request should not be completed, 1 if it should be evaluated further.
 	 */
-	int preprocess(void *id);
+	int preprocess(void *id, int address);
+	/**
+	 * Helper for preprocess. Called when this level is free.
+	 * @param the source making the request
+	 * @return 1 if `id' is chosen over the waiting requesters, 0 otherwise
+	 */
+	int arbitrate(void *id);
+	/**
+	 * Helper for arbitrate.
+	 * @param a waiting requester and the order it joined the queue in
+	 * @param another
+	 * @return 1 if `a' should be granted this level before `b', 0 otherwise
+	 */
+	int precedes(
+		const std::pair<void *, unsigned long> &a, const std::pair<void *, unsigned long> &b);
+	/**
+	 * @param a requester
+	 * @return the position of `id' in `requesters', adding it if it has not been seen
+	 */
+	int position(void *id);
+	/**
+	 * Helper for preprocess. Records that `id' was refused this cycle, queueing it if there is
+	 * room.
+	 * @param the source making the request
+	 */
+	void wait(void *id);
 	/**
 	 * Returns OK if `id` should complete its request this cycle. In the case it can, automatically
 	 * clears the current requester.
@@ -94,6 +475,17 @@ class Storage
 	 * @return 1 if the access can be carried out this function call, 0 otherwise.
 	 */
 	int is_data_ready();
+	/**
+	 * Completes the current request, allowing the next requester in. Records its latency, and
+	 * merges its ledger into the requester's if the requester is a level above this one.
+	 */
+	void release();
+	/**
+	 * Helper for release. Merges the ledger of a request this level made of `lower' into the
+	 * ledger of its current request.
+	 * @param the ledger of the request made
+	 */
+	void absorb(const Ledger &below);
 	/**
 	 * The data currently stored in this level of storage.
 	 */
@@ -103,6 +495,22 @@ class Storage
 	 * Used in case of cache misses.
 	 */
 	Storage *lower;
+	/**
+	 * Nonzero if this level deletes `lower' when it is deleted.
+	 */
+	int owns_lower;
+	/**
+	 * The levels directly above this one, which fill from it.
+	 */
+	std::vector<Storage *> uppers;
+	/**
+	 * The inclusion policy this level keeps with respect to `uppers'.
+	 */
+	enum Inclusion inclusion;
+	/**
+	 * Event counters, indexed by `enum Stat'.
+	 */
+	std::array<unsigned long, STAT_COUNT> stats;
 	/**
 	 * The id currently being serviced.
 	 */
@@ -116,6 +524,57 @@ class Storage
 	 * The number of cycles until the current request is completed.
 	 */
 	int wait_time;
+	/**
+	 * The number of cycles the current request has been serviced, including the current one.
+	 */
+	int elapsed;
+	/**
+	 * The address the current request was issued for.
+	 */
+	int request_address;
+	/**
+	 * The tracer this level reports to, or nullptr, and the level number it records against.
+	 */
+	Tracer *tracer;
+	int trace_level;
+	/**
+	 * The arbitration policy, and the number of requesters which may wait, or 0 for no limit.
+	 */
+	enum Arbitration arbitration;
+	unsigned int queue_depth;
+	/**
+	 * The requesters waiting, in the order they joined, and the number which have ever joined.
+	 * Each is paired with its position in that order.
+	 */
+	std::vector<std::pair<void *, unsigned long>> queue;
+	unsigned long arrivals;
+	/**
+	 * Every requester seen, in the order first seen, and the position of the last granted.
+	 */
+	std::vector<void *> requesters;
+	int last_granted;
+	/**
+	 * The priority and cycles refused of each requester.
+	 */
+	std::map<void *, int> priorities;
+	std::map<void *, unsigned long> waits;
+	/**
+	 * The cycles each requester has been refused since it was last granted this level.
+	 */
+	std::map<void *, unsigned long> refused;
+	/**
+	 * The ledger of the current request, or of the last if there is none.
+	 */
+	Ledger ledger;
+	/**
+	 * The number of requests completed with each latency. See `get_latency_histogram'.
+	 */
+	std::array<unsigned long, LATENCY_BUCKETS> histogram;
+	/**
+	 * The number of lines already written of each requester's burst, if it is written line by
+	 * line.
+	 */
+	std::map<void *, unsigned long> lines_written;
 };
 
 #endif /* STORAGE_H_INCLUDED */
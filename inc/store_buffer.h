@@ -0,0 +1,110 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef STORE_BUFFER_H
+#define STORE_BUFFER_H
+#include "definitions.h"
+#include "storage.h"
+#include <array>
+#include <deque>
+#include <functional>
+
+class StoreBuffer : public Storage
+{
+  public:
+	/**
+	 * Constructor.
+	 * Stores are retired the cycle they are made, and written to `lower' in the order they were
+	 * made, one request per line, as the buffer is ticked. Stores to a line already waiting are
+	 * merged into it, and drain with it. Loads of buffered words are forwarded from the buffer, and other loads go
+	 * straight to `lower'.
+	 * @param The level of storage stores drain into.
+	 * @param The number of lines which may be buffered.
+	 * @return A new, empty store buffer.
+	 */
+	StoreBuffer(Storage *lower, int entries);
+	~StoreBuffer();
+
+	int write_word(void *, signed int, int) override;
+	int write_line(void *, std::array<signed int, LINE_SIZE>, int) override;
+	int read_line(void *, int, std::array<signed int, LINE_SIZE> &) override;
+	int read_word(void *, int, signed int &) override;
+	int write_words(void *, std::array<signed int, LINE_SIZE>, int, unsigned int) override;
+	int read_words(void *, int, unsigned int, std::array<signed int, LINE_SIZE> &) override;
+	/**
+	 * Waits for the buffer to drain before performing `op' below it.
+	 */
+	int maintain(void *, enum Maintenance, int, int) override;
+	/**
+	 * Waits for the buffer to drain, then for the levels below it.
+	 */
+	int fence(void *) override;
+	/**
+	 * Advances the store being written to `lower' by one cycle, then `lower' if this buffer owns
+	 * it.
+	 */
+	void tick() override;
+	/**
+	 * @return the number of lines buffered
+	 */
+	int get_occupancy() const;
+
+  private:
+	/**
+	 * A buffered line: the address of its first word, a mask of the words stored, bit i for
+	 * word i, and their values.
+	 */
+	struct Entry {
+		int address;
+		unsigned int mask;
+		std::array<signed int, LINE_SIZE> line;
+	};
+	/**
+	 * Calls `request_handler' with `address' to forward the request to `lower', until it sets
+	 * `served'.
+	 */
+	int process(
+		void *id, int address, std::function<void(int index, int offset)> request_handler) override;
+	/**
+	 * Helper for write_word and write_line. Merges the words in `mask' into the entry for the
+	 * line containing `address', allocating one if there is none.
+	 * @param the address of a word in the line
+	 * @param the words to store
+	 * @param the values, indexed by word
+	 * @return 1 if the store was buffered, 0 if the buffer is full
+	 */
+	int store(int address, unsigned int mask, const std::array<signed int, LINE_SIZE> &line);
+	/**
+	 * The number of lines which may be buffered.
+	 */
+	int entries;
+	/**
+	 * The buffered lines, oldest first. The oldest is not merged into once it starts draining.
+	 */
+	std::deque<Entry> buffer;
+	int draining;
+	/**
+	 * The requester id stores are drained under.
+	 */
+	int drainer;
+	/**
+	 * Nonzero once `lower' has completed the current request.
+	 */
+	int served;
+};
+
+#endif /* STORE_BUFFER_H_INCLUDED */
@@ -0,0 +1,85 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include "storage.h"
+#include <string>
+#include <vector>
+
+/**
+ * A named level of a `Topology'.
+ */
+struct Level {
+	std::string name;
+	Storage *storage;
+};
+
+/**
+ * A hierarchy of any shape: a DAG of named levels, each filled from the level it was built over.
+ * Levels may share the level below them, such as split instruction and data caches over a
+ * unified cache, and the topology owns and deletes every level.
+ */
+class Topology
+{
+  public:
+	Topology() = default;
+	Topology(const Topology &) = delete;
+	Topology &operator=(const Topology &) = delete;
+	~Topology();
+
+	/**
+	 * Takes ownership of `level', which must be built over a level already added, if any.
+	 * Throws std::invalid_argument, leaving `level' with the caller, if `name' is taken.
+	 * @param the name to add `level' under
+	 * @param the level
+	 * @return `level'
+	 */
+	Storage *add(const std::string &name, Storage *level);
+	/**
+	 * @param the name of a level
+	 * @return the level added under `name', or nullptr if there is none
+	 */
+	Storage *find(const std::string &name) const;
+	/**
+	 * @return every level, in the order added, so each comes after the level below it
+	 */
+	const std::vector<Level> &get_levels() const;
+	/**
+	 * @return the levels no other level is built over, in the order added
+	 */
+	std::vector<Level> get_tops() const;
+	/**
+	 * Advances every level by one clock cycle, lowest first.
+	 */
+	void tick();
+	/**
+	 * Fences every level no other level is built over.
+	 * @param the source making the request.
+	 * @return 1 if no requests are in flight anywhere, 0 otherwise.
+	 */
+	int fence(void *id);
+	/**
+	 * Deletes every level, highest first.
+	 */
+	void clear();
+
+  private:
+	std::vector<Level> levels;
+};
+
+#endif /* TOPOLOGY_H_INCLUDED */
@@ -0,0 +1,201 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Records event `e' on `address' if a tracer is attached to this level of storage. Compiled out
+ * entirely when RAM_NO_TRACE is defined.
+ * @param the event
+ * @param the address the event concerns
+ */
+// clang-format off
+#ifdef RAM_NO_TRACE
+#define TRACE(e, a) do { } while (0)
+#else
+#define TRACE(e, a) \
+  do { if (this->tracer) this->tracer->record(this->trace_level, e, a); } while (0)
+#endif
+// clang-format on
+
+/**
+ * The events a level of storage reports to its tracer.
+ */
+enum Event { ISSUE, HIT, MISS, EVICT, WRITEBACK, COMPLETE };
+
+/**
+ * A single traced event.
+ */
+struct TraceRecord {
+	unsigned long cycle;
+	int address;
+	enum Event event;
+};
+
+class Tracer
+{
+  public:
+	/**
+	 * Constructor.
+	 * @param The number of bits required to specify an entry in each level's ring buffer.
+	 * @return A new tracer with no levels attached.
+	 */
+	Tracer(unsigned int capacity_spec);
+
+	/**
+	 * Allocates a ring buffer for a level of storage.
+	 * @param the name the level is exported under
+	 * @return the level number to record events against
+	 */
+	int attach(const char *name);
+	/**
+	 * Advances the cycle events are stamped with.
+	 */
+	void tick();
+	/**
+	 * @return the current cycle
+	 */
+	unsigned long now() const;
+	/**
+	 * Restricts recording to cycles in [`begin', `end'). Requests which straddle an edge of the
+	 * window are clipped to it.
+	 * @param the first cycle to record
+	 * @param the cycle to stop recording at
+	 */
+	void set_window(unsigned long begin, unsigned long end);
+	/**
+	 * Drains every ring buffer into `out' as a Chrome trace / Perfetto JSON document. Each level
+	 * is exported as a thread, with requests as duration slices and all other events as instants.
+	 * Requests still in flight are exported once they complete.
+	 * @param the stream to write to
+	 */
+	void write_chrome_trace(std::ostream &out);
+	/**
+	 * @param a level number returned by `attach'
+	 * @return the number of events dropped because that level's ring buffer was full
+	 */
+	unsigned long get_dropped(int level) const;
+
+	/**
+	 * Appends an event to `level''s ring buffer. Events are dropped, rather than overwriting older
+	 * ones, when the buffer is full.
+	 * @param a level number returned by `attach'
+	 * @param the event
+	 * @param the address the event concerns
+	 */
+	inline void
+	record(int level, enum Event event, int address)
+	{
+		if (event == ISSUE || event == COMPLETE)
+			this->record_request(level, event, address);
+		else if (this->cycle >= this->begin && this->cycle < this->end)
+			this->rings[level]->push({this->cycle, address, event});
+	}
+
+  private:
+	/**
+	 * Notes the issue of a request, or appends the slice for a completed one, clipped to the
+	 * window, so that both ends of every slice are written or neither is.
+	 * @param a level number returned by `attach'
+	 * @param ISSUE or COMPLETE
+	 * @param the address the request concerns
+	 */
+	void record_request(int level, enum Event event, int address);
+
+	/**
+	 * A single-producer, single-consumer lock-free ring buffer.
+	 */
+	class Ring
+	{
+	  public:
+		Ring(unsigned int capacity_spec);
+
+		inline void
+		push(const TraceRecord &r)
+		{
+			unsigned long h;
+
+			h = this->head.load(std::memory_order_relaxed);
+			if (h - this->tail.load(std::memory_order_acquire) > this->mask) {
+				this->dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			this->buffer[h & this->mask] = r;
+			this->head.store(h + 1, std::memory_order_release);
+		}
+		/**
+		 * Appends both `b' and `e', or drops both if they do not fit.
+		 */
+		inline void
+		push_pair(const TraceRecord &b, const TraceRecord &e)
+		{
+			unsigned long h;
+
+			h = this->head.load(std::memory_order_relaxed);
+			if (h - this->tail.load(std::memory_order_acquire) + 1 > this->mask) {
+				this->dropped.fetch_add(2, std::memory_order_relaxed);
+				return;
+			}
+			this->buffer[h & this->mask] = b;
+			this->buffer[(h + 1) & this->mask] = e;
+			this->head.store(h + 2, std::memory_order_release);
+		}
+		/**
+		 * @param set to the oldest entry, if there is one
+		 * @return 1 if an entry was removed, 0 if the buffer was empty
+		 */
+		int pop(TraceRecord &r);
+
+		std::vector<TraceRecord> buffer;
+		unsigned long mask;
+		std::atomic<unsigned long> dropped;
+		std::atomic<unsigned long> head;
+		std::atomic<unsigned long> tail;
+		/**
+		 * The cycle the request in flight was issued, and nonzero while one is.
+		 */
+		unsigned long issued;
+		int pending;
+	};
+
+	/**
+	 * The ring buffer and exported name of each attached level.
+	 */
+	std::vector<std::unique_ptr<Ring>> rings;
+	std::vector<std::string> names;
+	/**
+	 * The number of bits required to specify an entry in each ring buffer.
+	 */
+	unsigned int capacity_spec;
+	/**
+	 * The current cycle.
+	 */
+	unsigned long cycle;
+	/**
+	 * The recording window.
+	 */
+	unsigned long begin;
+	unsigned long end;
+};
+
+#endif /* TRACER_H_INCLUDED */
@@ -0,0 +1,199 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "bus.h"
+#include "definitions.h"
+#include <bit>
+#include <stdexcept>
+
+Bus::Bus(Storage *lower, int width, int ratio) : Storage(0)
+{
+	if (width < 1 || ratio < 1)
+		throw std::invalid_argument("Bus width and clock ratio must be positive.");
+
+	this->lower = lower;
+	this->width = width;
+	this->ratio = ratio;
+	this->words = 0;
+	this->served = 0;
+	this->set_arbitration(ROUND_ROBIN, 0);
+	this->lower->add_upper(this);
+}
+
+Bus::~Bus()
+{
+	if (this->owns_lower)
+		delete this->lower;
+	delete this->data;
+}
+
+int
+Bus::write_word(void *id, signed int data, int address)
+{
+	this->words = 1;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->write_word(this, data, target);
+	});
+}
+
+int
+Bus::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	this->words = LINE_SIZE;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->write_line(this, data_line, target);
+	});
+}
+
+int
+Bus::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	this->words = LINE_SIZE;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_line(this, target, data_line);
+	});
+}
+
+int
+Bus::read_word(void *id, int address, signed int &data)
+{
+	this->words = 1;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_word(this, target, data);
+	});
+}
+
+int
+Bus::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	this->words = std::popcount(mask);
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->write_words(this, data_line, target, mask);
+	});
+}
+
+int
+Bus::write_victim(void *id, std::array<signed int, LINE_SIZE> data_line, int address, int dirty)
+{
+	this->words = LINE_SIZE;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->write_victim(this, data_line, target, dirty);
+	});
+}
+
+int
+Bus::write_lines(void *id, const std::vector<LineWrite> &lines)
+{
+	if (lines.empty())
+		return 1;
+
+	this->words = 0;
+	for (const LineWrite &l : lines)
+		this->words += std::popcount(l.mask);
+	return process(id, lines.front().address, [&](int target, int offset) {
+		(void)target;
+		(void)offset;
+		this->served = this->lower->write_lines(this, lines);
+	});
+}
+
+int
+Bus::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	this->words = std::popcount(mask);
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_words(this, target, mask, data_line);
+	});
+}
+
+int
+Bus::read_word_non_temporal(void *id, int address, signed int &data)
+{
+	this->words = 1;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_word_non_temporal(this, target, data);
+	});
+}
+
+int
+Bus::read_words_non_temporal(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	this->words = std::popcount(mask);
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_words_non_temporal(this, target, mask, data_line);
+	});
+}
+
+int
+Bus::write_word_non_temporal(void *id, signed int data, int address)
+{
+	this->words = 1;
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->write_word_non_temporal(this, data, target);
+	});
+}
+
+int
+Bus::back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->invalidate_uppers(address, data_line);
+}
+
+enum Inclusion
+Bus::get_inclusion() const
+{
+	return this->lower->get_inclusion();
+}
+
+double
+Bus::get_utilization(unsigned long cycles) const
+{
+	return cycles ? static_cast<double>(this->stats[BUS_BUSY_CYCLES]) / cycles : 0.0;
+}
+
+int
+Bus::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+{
+	if (!this->preprocess(id, address))
+		return 0;
+
+	++this->stats[BUS_BUSY_CYCLES];
+	if (!this->served) {
+		request_handler(address, 0);
+		if (!this->served)
+			return 0;
+		// the data crosses in whole bus cycles once `lower' responds
+		this->wait_time = (this->words + this->width - 1) / this->width * this->ratio;
+	}
+
+	if (!this->is_data_ready())
+		return 0;
+
+	this->served = 0;
+	return 1;
+}
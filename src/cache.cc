@@ -17,10 +17,13 @@
 
 #include "cache.h"
 #include "definitions.h"
+#include <bit>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <limits.h>
+#include <stdexcept>
 
 Cache::Cache(Storage *lower, unsigned int size, unsigned int ways, int delay) : Storage(delay)
 {
@@ -35,121 +38,1490 @@ Cache::Cache(Storage *lower, unsigned int size, unsigned int ways, int delay) :
 	// store the number of bits which are moved into the tag field
 	this->ways = ways;
 	this->access_num = 0;
+	this->missed = 0;
+	this->filled = 0;
+	this->critical_word_first = 0;
+	this->stream_index = -1;
+	this->stream_word = 0;
+	this->stream_elapsed = 0;
+	this->evicting = 0;
+	this->tag_spec = 0;
+	this->decompress_delay = 0;
+	this->charged = 0;
+	this->penalty = 0;
+	this->way_prediction = 0;
+	this->fast_delay = 0;
+	this->mispredict_penalty = 0;
+	this->guessed = 0;
+	this->active = 0;
+	this->interval = 0;
+	this->since = 0;
+	this->classify = 0;
+	this->sector_spec = 0;
+	this->neighbors = 0;
+	this->access_mask = 0;
+	this->indexing = MODULO;
+	this->prime = 0;
+	this->non_temporal = 0;
+	this->victim = nullptr;
+	this->maintaining = 0;
+	this->burst_placed = 0;
+	this->rebuild_lookup();
+	this->lower->add_upper(this);
 }
 
 Cache::~Cache()
 {
-	delete this->lower;
+	if (this->owns_lower)
+		delete this->lower;
 	delete this->data;
 }
 
 unsigned int
 Cache::get_size() { return this->size; }
 
+const std::array<signed int, 3> &
+Cache::view_meta(int index) const
+{
+	return this->meta.at(index);
+}
+
+Cache::LineRange
+Cache::lines(enum LineFilter filter) const
+{
+	return LineRange(this, filter);
+}
+
+Cache::LineRange::LineRange(const Cache *cache, enum LineFilter filter)
+{
+	this->cache = cache;
+	this->filter = filter;
+}
+
+Cache::LineIterator
+Cache::LineRange::begin() const
+{
+	return LineIterator(this->cache, 0, this->filter);
+}
+
+Cache::LineIterator
+Cache::LineRange::end() const
+{
+	return LineIterator(this->cache, this->cache->meta.size(), this->filter);
+}
+
+Cache::LineIterator::LineIterator(const Cache *cache, int index, enum LineFilter filter)
+{
+	this->cache = cache;
+	this->index = index;
+	this->filter = filter;
+	this->skip();
+}
+
+CacheLine
+Cache::LineIterator::operator*() const
+{
+	return {
+		this->index,
+		this->cache->line_address(this->index),
+		&this->cache->meta[this->index],
+		&(*this->cache->data)[this->index]};
+}
+
+Cache::LineIterator &
+Cache::LineIterator::operator++()
+{
+	++this->index;
+	this->skip();
+	return *this;
+}
+
+bool
+Cache::LineIterator::operator!=(const LineIterator &other) const
+{
+	return this->index != other.index;
+}
+
+void
+Cache::LineIterator::skip()
+{
+	const std::vector<std::array<signed int, 3>> &meta = this->cache->meta;
+
+	while (static_cast<size_t>(this->index) < meta.size() &&
+		   (meta[this->index][0] < 0 || (this->filter == DIRTY_LINES && meta[this->index][1] < 0)))
+		++this->index;
+}
+
+void
+Cache::set_inclusion(enum Inclusion inclusion)
+{
+	if (inclusion == EXCLUSIVE && this->sector_spec)
+		throw std::invalid_argument("A sectored cache cannot be exclusive.");
+	this->inclusion = inclusion;
+}
+
+void
+Cache::set_sectors(unsigned int sector_spec, unsigned int neighbors)
+{
+	unsigned long i;
+
+	if (sector_spec > LINE_SPEC)
+		throw std::invalid_argument("Sectors cannot be smaller than a word.");
+	if (sector_spec && this->inclusion == EXCLUSIVE)
+		throw std::invalid_argument("A sectored cache cannot be exclusive.");
+
+	this->sector_spec = sector_spec;
+	this->neighbors = neighbors;
+	this->valid_words.assign(this->meta.size(), 0);
+	this->dirty_words.assign(this->meta.size(), 0);
+	if (!sector_spec)
+		return;
+	// lines already held are whole
+	for (i = 0; i < this->meta.size(); ++i) {
+		if (this->meta[i][0] >= 0)
+			this->valid_words[i] = (1U << LINE_SIZE) - 1;
+		if (this->meta[i][0] >= 0 && this->meta[i][1] >= 0)
+			this->dirty_words[i] = (1U << LINE_SIZE) - 1;
+	}
+}
+
+unsigned int
+Cache::get_valid_words(int index) const
+{
+	if (this->meta.at(index).at(0) < 0)
+		return 0;
+	return this->sector_spec ? this->valid_words.at(index) : (1U << LINE_SIZE) - 1;
+}
+
+unsigned int
+Cache::get_dirty_words(int index) const
+{
+	if (this->meta.at(index).at(0) < 0 || this->meta.at(index).at(1) < 0)
+		return 0;
+	return this->sector_spec ? this->dirty_words.at(index) : (1U << LINE_SIZE) - 1;
+}
+
+void
+Cache::set_critical_word_first(int enable) { this->critical_word_first = enable; }
+
+void
+Cache::set_indexing(enum Indexing indexing)
+{
+	int sets;
+
+	if (indexing == SKEWED && (this->tag_spec || this->way_prediction))
+		throw std::invalid_argument(
+			"Skewed indexing cannot be combined with compression or way prediction.");
+
+	sets = 1 << (this->size - this->ways);
+	for (this->prime = sets; this->prime > 2; --this->prime) {
+		int d;
+
+		for (d = 2; d * d <= this->prime && this->prime % d; ++d)
+			;
+		if (d * d > this->prime)
+			break;
+	}
+
+	this->meta.assign(this->meta.size(), {-1, -1, -1});
+	this->valid_words.assign(this->valid_words.size(), 0);
+	this->dirty_words.assign(this->dirty_words.size(), 0);
+	this->stream_index = -1;
+	this->indexing = indexing;
+	this->rebuild_lookup();
+}
+
+void
+Cache::set_compression(unsigned int tag_spec, int decompress_delay)
+{
+	int true_size;
+
+	if (this->indexing == SKEWED)
+		throw std::invalid_argument(
+			"Skewed indexing cannot be combined with compression or way prediction.");
+
+	true_size = 1 << (this->size + tag_spec);
+	this->data->assign(true_size, {});
+	this->meta.assign(true_size, {-1, -1, -1});
+	this->csize.assign(true_size, 0);
+	if (this->sector_spec) {
+		this->valid_words.assign(true_size, 0);
+		this->dirty_words.assign(true_size, 0);
+	}
+	if (!this->partitions.empty())
+		this->owner.assign(true_size, 0);
+	this->tag_spec = tag_spec;
+	this->decompress_delay = decompress_delay;
+	this->rebuild_lookup();
+}
+
+void
+Cache::set_way_prediction(int fast_delay, int penalty)
+{
+	if (this->indexing == SKEWED)
+		throw std::invalid_argument(
+			"Skewed indexing cannot be combined with compression or way prediction.");
+
+	this->predicted.assign(1 << (this->size - this->ways), 0);
+	this->way_prediction = 1;
+	this->fast_delay = fast_delay;
+	this->mispredict_penalty = penalty;
+}
+
+void
+Cache::set_partition(void *id, unsigned int partition)
+{
+	this->add_partitions(partition);
+	this->placement[id] = partition;
+}
+
+void
+Cache::set_way_mask(unsigned int partition, const std::vector<bool> &ways)
+{
+	if (ways.size() != 1UL << this->ways || std::find(ways.begin(), ways.end(), true) == ways.end())
+		throw std::invalid_argument("Way mask must select at least one way, and only ways held.");
+
+	this->add_partitions(partition);
+	this->partitions[partition].ways = ways;
+}
+
+void
+Cache::set_way_mask(unsigned int partition, unsigned long mask)
+{
+	std::vector<bool> ways;
+	unsigned long i;
+
+	// shifting by the width of `mask' or more is undefined
+	if (this->ways < 6 && mask >> (1 << this->ways))
+		throw std::invalid_argument("Way mask must select at least one way, and only ways held.");
+
+	ways.assign(1UL << this->ways, false);
+	for (i = 0; i < 64 && i < ways.size(); ++i)
+		ways[i] = mask >> i & 1;
+	this->set_way_mask(partition, ways);
+}
+
+void
+Cache::set_dynamic_partitioning(unsigned long interval)
+{
+	this->add_partitions(0);
+	this->interval = interval;
+	this->since = 0;
+}
+
+void
+Cache::set_miss_classification(int enable)
+{
+	this->classify = enable;
+	this->touched.clear();
+	this->fa_order.clear();
+	this->fa_lines.clear();
+}
+
+const std::vector<bool> &
+Cache::get_ways(unsigned int partition) const
+{
+	return this->partitions.at(partition).ways;
+}
+
+unsigned long
+Cache::get_way_mask(unsigned int partition) const
+{
+	unsigned long i, r;
+
+	if (this->ways > 6)
+		throw std::out_of_range("Way masks only hold up to 64 ways.");
+
+	r = 0;
+	for (i = 0; i < this->get_ways(partition).size(); ++i)
+		r |= static_cast<unsigned long>(this->partitions[partition].ways[i]) << i;
+	return r;
+}
+
+unsigned long
+Cache::get_occupancy(unsigned int partition) const
+{
+	unsigned long i, r;
+
+	this->partitions.at(partition);
+	r = 0;
+	for (i = 0; i < this->meta.size(); ++i)
+		if (this->meta[i][0] >= 0 && this->owner[i] == partition)
+			++r;
+	return r;
+}
+
+unsigned long
+Cache::get_partition_stat(unsigned int partition, enum Stat s) const
+{
+	if (s != HITS && s != MISSES)
+		return 0;
+	return this->partitions.at(partition).counts[s == MISSES];
+}
+
+unsigned int
+Cache::partition_of(void *id) const
+{
+	if (this->placement.empty())
+		return 0;
+
+	auto it = this->placement.find(id);
+	return it == this->placement.end() ? 0 : it->second;
+}
+
+void
+Cache::add_partitions(unsigned int partition)
+{
+	if (this->partitions.empty())
+		this->owner.assign(this->meta.size(), 0);
+
+	while (this->partitions.size() <= partition)
+		this->partitions.push_back(
+			{std::vector<bool>(1UL << this->ways, true),
+			 {0, 0},
+			 std::vector<std::vector<int>>(1 << (this->size - this->ways)),
+			 std::vector<unsigned long>(1 << this->ways, 0)});
+}
+
 int
 Cache::write_word(void *id, signed int data, int address)
 {
+	this->access_mask = 1U << GET_LS_BITS(WRAP_ADDRESS(address), LINE_SPEC);
 	return process(id, address, [&](int index, int offset) {
 		this->data->at(index).at(offset) = data;
-		this->meta[index].at(1) = 1;
+		this->mark_dirty(index, this->access_mask);
 	});
 }
 
 int
 Cache::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
 {
+	this->access_mask = (1U << LINE_SIZE) - 1;
 	return process(id, address, [&](int index, int offset) {
 		(void)offset;
 		this->data->at(index) = data_line;
-		this->meta[index].at(1) = 1;
+		this->mark_dirty(index, this->access_mask);
 	});
 }
 
+int
+Cache::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	this->access_mask = mask;
+	return process(id, address, [&](int index, int offset) {
+		(void)offset;
+		for (offset = 0; offset < LINE_SIZE; ++offset)
+			if (mask >> offset & 1)
+				this->data->at(index).at(offset) = data_line[offset];
+		this->mark_dirty(index, mask);
+	});
+}
+
+int
+Cache::write_victim(void *id, std::array<signed int, LINE_SIZE> data_line, int address, int dirty)
+{
+	int r;
+
+	if (this->inclusion != EXCLUSIVE)
+		return Storage::write_victim(id, data_line, address, dirty);
+
+	this->access_mask = (1U << LINE_SIZE) - 1;
+	this->victim = &data_line;
+	r = process(id, address, [&](int index, int offset) {
+		(void)offset;
+		this->data->at(index) = data_line;
+		if (dirty)
+			this->mark_dirty(index, this->access_mask);
+	});
+	this->victim = nullptr;
+	return r;
+}
+
+int
+Cache::write_lines(void *id, const std::vector<LineWrite> &lines)
+{
+	const LineWrite *l;
+	int address, tag, index, offset, r;
+
+	if (lines.empty())
+		return 1;
+	if (!preprocess(id, WRAP_ADDRESS(lines.front().address)))
+		return 0;
+	this->active = this->partition_of(id);
+	this->advance_stream();
+	if (this->elapsed == 1)
+		this->wait_time += lines.size() - 1;
+
+	for (; this->burst_placed < lines.size(); ++this->burst_placed) {
+		l = &lines[this->burst_placed];
+		address = WRAP_ADDRESS(l->address);
+		this->request_address = address;
+		this->access_mask = l->mask;
+		// whole lines need nothing from `lower' if this level only holds what is swapped into it
+		if (this->inclusion == EXCLUSIVE && l->mask == (1U << LINE_SIZE) - 1)
+			this->victim = &l->data;
+		r = priming_address(address);
+		this->victim = nullptr;
+		if (r)
+			return 0;
+
+		this->get_fields(address, &tag, &index, &offset);
+		index = this->search_ways_for(index, tag);
+		if (this->is_streaming(index, -1) || this->is_decompressing(index))
+			return 0;
+		for (offset = 0; offset < LINE_SIZE; ++offset)
+			if (l->mask >> offset & 1)
+				this->data->at(index).at(offset) = l->data[offset];
+		this->mark_dirty(index, l->mask);
+		this->record_access(index);
+	}
+
+	if (!this->is_data_ready())
+		return 0;
+
+	this->burst_placed = 0;
+	return 1;
+}
+
 int
 Cache::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
 {
+	if (this->inclusion == EXCLUSIVE)
+		return this->read_line_exclusive(id, address, data_line);
+
+	this->access_mask = (1U << LINE_SIZE) - 1;
 	return process(id, address, [&](int index, int offset) {
 		(void)offset;
 		data_line = this->data->at(index);
 	});
 }
 
+int
+Cache::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	std::array<signed int, LINE_SIZE> line;
+
+	if (this->inclusion == EXCLUSIVE) {
+		// the line leaves this level whole
+		if (!this->read_line_exclusive(id, address, line))
+			return 0;
+	} else {
+		this->access_mask = mask;
+		if (!process(id, address, [&](int index, int offset) {
+				(void)offset;
+				line = this->data->at(index);
+			}))
+			return 0;
+	}
+
+	for (int i = 0; i < LINE_SIZE; ++i)
+		if (mask >> i & 1)
+			data_line[i] = line[i];
+	return 1;
+}
+
 int
 Cache::read_word(void *id, int address, signed int &data)
 {
-	return process(
-		id, address, [&](int index, int offset) { data = this->data->at(index).at(offset); });
+	int r;
+
+	this->access_mask = 1U << GET_LS_BITS(WRAP_ADDRESS(address), LINE_SPEC);
+
+	if (this->critical_word_first)
+		r = this->read_word_early(id, address, data);
+	else
+		r = process(
+			id, address, [&](int index, int offset) { data = this->data->at(index).at(offset); });
+
+	if (r) {
+		++this->stats[LOADS];
+		this->stats[LOAD_CYCLES] += this->elapsed;
+	}
+	return r;
+}
+
+int
+Cache::read_word_non_temporal(void *id, int address, signed int &data)
+{
+	int r;
+
+	this->non_temporal = 1;
+	r = this->read_word(id, address, data);
+	this->non_temporal = 0;
+	return r;
+}
+
+int
+Cache::read_words_non_temporal(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int r;
+
+	this->non_temporal = 1;
+	r = this->read_words(id, address, mask, data_line);
+	this->non_temporal = 0;
+	return r;
+}
+
+int
+Cache::write_word_non_temporal(void *id, signed int data, int address)
+{
+	int tag, index, offset, r;
+
+	address = WRAP_ADDRESS(address);
+	this->get_fields(address, &tag, &index, &offset);
+	if (this->meta.at(this->search_ways_for(index, tag)).at(0) == tag) {
+		this->non_temporal = 1;
+		r = this->write_word(id, data, address);
+		this->non_temporal = 0;
+		return r;
+	}
+
+	if (!preprocess(id, address) || !this->lower->write_word_non_temporal(this, data, address))
+		return 0;
+	this->release();
+	TRACE(MISS, address);
+	++this->stats[MISSES];
+	++this->stats[BYPASSES];
+	return 1;
+}
+
+int
+Cache::prefetch(void *id, int address, int level)
+{
+	(void)id;
+	if (level > 0)
+		return this->lower->prefetch(this, address, level - 1);
+	// exclusive levels are only filled by their uppers
+	if (this->inclusion == EXCLUSIVE)
+		return 1;
+
+	address = WRAP_ADDRESS(address) & ~(LINE_SIZE - 1);
+	if (std::find(this->prefetches.begin(), this->prefetches.end(), address) !=
+		this->prefetches.end())
+		return 1;
+	if (this->prefetches.size() >= PREFETCH_QUEUE_SIZE)
+		return 0;
+	this->prefetches.push_back(address);
+	return 1;
+}
+
+void
+Cache::tick()
+{
+	int tag, index, offset, address;
+
+	Storage::tick();
+	if (this->prefetches.empty())
+		return;
+
+	address = this->prefetches.front();
+	this->get_fields(address, &tag, &index, &offset);
+	if (this->current_request != this) {
+		index = this->search_ways_for(index, tag);
+		if (this->meta.at(index).at(0) == tag &&
+			this->get_valid_words(index) == (1U << LINE_SIZE) - 1) {
+			this->prefetches.pop_front();
+			return;
+		}
+	}
+
+	if (!preprocess(this, address))
+		return;
+	this->active = 0;
+	this->access_mask = (1U << LINE_SIZE) - 1;
+	this->advance_stream();
+	if (priming_address(address))
+		return;
+
+	// the requester did not wait, so the line is not read out
+	this->get_fields(address, &tag, &index, &offset);
+	index = this->search_ways_for(index, tag);
+	this->set_usage(index, this->access_num % INT_MAX);
+	++this->access_num;
+	this->missed = 0;
+	this->filled = 0;
+	this->release();
+	this->prefetches.pop_front();
+	this->prefetched.insert(address >> LINE_SPEC);
+	++this->stats[PREFETCHES];
 }
 
 int
 Cache::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
 {
 	address = WRAP_ADDRESS(address);
-	if (!preprocess(id) || priming_address(address) || !this->is_data_ready())
+	if (!preprocess(id, address))
+		return 0;
+	this->active = this->partition_of(id);
+	this->advance_stream();
+	if (priming_address(address))
 		return 0;
 
 	int tag, index, offset;
-	std::array<int, 3> *meta;
 
-	GET_FIELDS(address, &tag, &index, &offset);
+	this->get_fields(address, &tag, &index, &offset);
 	index = this->search_ways_for(index, tag);
+	this->check_prediction(index);
+	if (this->is_streaming(index, -1) || this->is_decompressing(index) || !this->is_data_ready())
+		return 0;
+
 	request_handler(index, offset);
-	// set usage status
+	this->record_access(index);
+
+	return 1;
+}
+
+int
+Cache::read_word_early(void *id, int address, signed int &data)
+{
+	int tag, index, offset;
+
+	address = WRAP_ADDRESS(address);
+	if (!preprocess(id, address))
+		return 0;
+	this->active = this->partition_of(id);
+	this->advance_stream();
+	if (priming_address(address) && !this->filled)
+		return 0;
+
+	this->get_fields(address, &tag, &index, &offset);
+	index = this->search_ways_for(index, tag);
+	if (this->filled) {
+		// forward the critical word the cycle it arrives, the rest of the line streams in behind it
+		this->stream_index = index;
+		this->stream_word = offset;
+		this->stream_elapsed = 0;
+		this->release();
+		++this->stats[EARLY_RESTARTS];
+	} else {
+		this->check_prediction(index);
+		if (this->is_streaming(index, offset) || this->is_decompressing(index) ||
+			!this->is_data_ready())
+			return 0;
+	}
+
+	data = this->data->at(index).at(offset);
+	this->record_access(index);
+
+	return 1;
+}
+
+void
+Cache::record_access(int index)
+{
+	// set usage status, leaving non-temporal lines next in line for eviction
+	if (!this->non_temporal) {
+		this->set_usage(index, this->access_num % INT_MAX);
+		++this->access_num;
+	} else if (this->missed)
+		this->set_usage(index, -1);
+	if (!this->prefetched.empty() && this->prefetched.erase(this->request_address >> LINE_SPEC))
+		++this->stats[USEFUL_PREFETCHES];
+	if (this->missed)
+		++this->stats[MISSES];
+	else {
+		TRACE(HIT, this->request_address);
+		++this->stats[HITS];
+	}
+	if (!this->partitions.empty())
+		this->track_utility(index);
+	if (this->classify)
+		this->classify_access();
+	this->missed = 0;
+	this->filled = 0;
+	this->charged = 0;
+	this->guessed = 0;
+	if (this->tag_spec)
+		this->csize.at(index) = compressed_size(this->data->at(index));
+	if (this->way_prediction)
+		this->predicted.at(index >> (this->ways + this->tag_spec)) =
+			index & ((1 << (this->ways + this->tag_spec)) - 1);
+}
+
+void
+Cache::classify_access()
+{
+	int line;
+
+	line = this->request_address >> LINE_SPEC;
+	auto it = this->fa_lines.find(line);
+	if (this->missed) {
+		if (this->touched.insert(line).second)
+			++this->stats[COMPULSORY_MISSES];
+		else if (it == this->fa_lines.end())
+			++this->stats[CAPACITY_MISSES];
+		else
+			++this->stats[CONFLICT_MISSES];
+	}
+
+	if (it != this->fa_lines.end()) {
+		this->fa_order.splice(this->fa_order.begin(), this->fa_order, it->second);
+		return;
+	}
+	if (this->fa_order.size() == 1UL << this->size) {
+		this->fa_lines.erase(this->fa_order.back());
+		this->fa_order.pop_back();
+	}
+	this->fa_order.push_front(line);
+	this->fa_lines[line] = this->fa_order.begin();
+}
+
+void
+Cache::track_utility(int index)
+{
+	Partition *p;
+	std::vector<int> *shadow;
+	int tag;
+	unsigned long i;
+
+	p = &this->partitions[this->active];
+	++p->counts[this->missed];
+	if (!this->interval)
+		return;
+
+	// the shadow tags of a set are kept most recently used first
+	tag = this->meta.at(index).at(0);
+	shadow = &p->shadow.at(index >> (this->ways + this->tag_spec));
+	for (i = 0; i < shadow->size() && (*shadow)[i] != tag; ++i)
+		;
+	if (i < shadow->size()) {
+		++p->utility[i];
+		shadow->erase(shadow->begin() + i);
+	} else if (shadow->size() == p->utility.size())
+		shadow->pop_back();
+	shadow->insert(shadow->begin(), tag);
+
+	if (++this->since >= this->interval) {
+		this->since = 0;
+		this->repartition();
+	}
+}
+
+void
+Cache::repartition()
+{
+	std::vector<int> share;
+	unsigned long p, best;
+	int left, first;
+
+	if (this->partitions.size() > 1UL << this->ways)
+		return;
+
+	// give each way to the partition it would add the most hits to
+	share.assign(this->partitions.size(), 1);
+	for (left = (1 << this->ways) - this->partitions.size(); left > 0; --left) {
+		best = 0;
+		for (p = 1; p < this->partitions.size(); ++p)
+			if (this->partitions[p].utility[share[p]] >
+				this->partitions[best].utility[share[best]])
+				best = p;
+		++share[best];
+	}
+
+	first = 0;
+	for (p = 0; p < this->partitions.size(); ++p) {
+		this->partitions[p].ways.assign(1UL << this->ways, false);
+		std::fill_n(this->partitions[p].ways.begin() + first, share[p], true);
+		first += share[p];
+		// older behaviour counts for less
+		for (unsigned long &u : this->partitions[p].utility)
+			u >>= 1;
+	}
+}
+
+void
+Cache::check_prediction(int index)
+{
+	int set;
+
+	if (!this->way_prediction || this->guessed)
+		return;
+
+	this->guessed = 1;
+	// fills arrive into the way they were placed in
+	if (this->missed)
+		return;
+
+	set = index >> (this->ways + this->tag_spec);
+	if (this->predicted.at(set) == (index & ((1 << (this->ways + this->tag_spec)) - 1))) {
+		this->wait_time = std::min(this->wait_time, this->fast_delay);
+		++this->stats[PREDICTED_WAYS];
+	} else {
+		this->wait_time += this->mispredict_penalty;
+		++this->stats[MISPREDICTED_WAYS];
+	}
+}
+
+void
+Cache::advance_stream()
+{
+	if (this->stream_index >= 0 && ++this->stream_elapsed >= LINE_SIZE - 1)
+		this->stream_index = -1;
+}
+
+int
+Cache::is_streaming(int index, int offset)
+{
+	int r;
+
+	if (index != this->stream_index)
+		return 0;
+
+	// words arrive one per cycle, wrapping around from the critical word
+	if (offset < 0)
+		r = this->stream_elapsed < LINE_SIZE - 1;
+	else
+		r = ((offset - this->stream_word) & (LINE_SIZE - 1)) > this->stream_elapsed;
+
+	if (r)
+		++this->stats[STREAM_STALLS];
+	return r;
+}
+
+int
+Cache::read_line_exclusive(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int tag, index, offset;
+	std::array<int, 3> *meta;
+
+	address = WRAP_ADDRESS(address);
+	if (!preprocess(id, address))
+		return 0;
+
+	this->get_fields(address, &tag, &index, &offset);
+	index = this->search_ways_for(index, tag);
 	meta = &this->meta.at(index);
-	meta->at(2) = (this->access_num % INT_MAX);
-	++this->access_num;
 
+	if (meta->at(0) != tag) {
+		if (!this->lower->read_line(this, address, data_line))
+			return 0;
+		this->release();
+		TRACE(MISS, address);
+		++this->stats[MISSES];
+		return 1;
+	}
+
+	if (!this->is_data_ready())
+		return 0;
+
+	// the requester now holds the only copy
+	data_line = this->data->at(index);
+	this->clear_line(index);
+	TRACE(HIT, address);
+	++this->stats[HITS];
+
+	return 1;
+}
+
+int
+Cache::back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int tag, index, offset, r;
+	std::array<int, 3> *meta;
+
+	// copies above this level are at least as recent as this one
+	r = this->invalidate_uppers(address, data_line);
+
+	this->get_fields(address, &tag, &index, &offset);
+	index = this->search_ways_for(index, tag);
+	meta = &this->meta.at(index);
+
+	if (meta->at(0) == tag) {
+		if (!this->prefetched.empty() && this->prefetched.erase(address >> LINE_SPEC))
+			++this->stats[USELESS_PREFETCHES];
+		if (index == this->stream_index)
+			this->stream_index = -1;
+		if (r < 2 && meta->at(1) >= 0) {
+			// clean words held match the level below, so only words not held are left alone
+			for (offset = 0; offset < LINE_SIZE; ++offset)
+				if (this->get_valid_words(index) >> offset & 1)
+					data_line[offset] = this->data->at(index).at(offset);
+			r = 2;
+		}
+		r = std::max(r, 1);
+		this->clear_line(index);
+	}
+
+	return r;
+}
+
+int
+Cache::maintain(void *id, enum Maintenance op, int start, int end)
+{
+	int address;
+
+	if (!preprocess(id, start))
+		return 0;
+
+	++this->stats[MAINTENANCE_CYCLES];
+	if (!this->maintaining) {
+		this->maintaining = 1;
+		this->collect(op == CLEAN ? DIRTY_LINES : VALID_LINES, start, end);
+		for (int t : this->batch) {
+			address = this->line_address(t);
+			// dirty copies above this level are newer, and must not outlive this one
+			if (op != CLEAN && this->inclusion == INCLUSIVE &&
+				this->invalidate_uppers(address, this->data->at(t)) == 2)
+				this->mark_dirty(t, (1U << LINE_SIZE) - 1);
+			if (op != INVALIDATE && this->meta[t][1] >= 0)
+				this->burst.push_back({address, this->written_words(t), this->data->at(t)});
+		}
+	}
+
+	// the dirty lines leave as one burst, so `lower' may overlap their writes
+	if (!this->burst.empty()) {
+		if (!this->lower->write_lines(this, this->burst))
+			return 0;
+		for (const LineWrite &l : this->burst) {
+			TRACE(WRITEBACK, l.address);
+			this->stats[WRITEBACK_WORDS_SAVED] += LINE_SIZE - std::popcount(l.mask);
+		}
+		this->stats[WRITEBACKS] += this->burst.size();
+		this->burst.clear();
+		for (int t : this->batch) {
+			this->meta[t][1] = -1;
+			if (this->sector_spec)
+				this->dirty_words[t] = 0;
+		}
+	}
+
+	if (op != CLEAN) {
+		for (int t : this->batch) {
+			if (this->meta[t][0] < 0)
+				continue;
+			address = this->line_address(t);
+			if (!this->prefetched.empty() && this->prefetched.erase(address >> LINE_SPEC))
+				++this->stats[USELESS_PREFETCHES];
+			if (t == this->stream_index)
+				this->stream_index = -1;
+			this->clear_line(t);
+		}
+	}
+	this->batch.clear();
+
+	// `lower' is asked once, not again while this level's own delay elapses
+	if (this->maintaining == 1) {
+		if (!this->lower->maintain(this, op, start, end))
+			return 0;
+		this->maintaining = 2;
+	}
+	if (!this->is_data_ready())
+		return 0;
+
+	this->maintaining = 0;
 	return 1;
 }
 
+void
+Cache::collect(enum LineFilter filter, int start, int end)
+{
+	int address, tag, index, offset;
+
+	this->batch.clear();
+
+	if ((end - start) / LINE_SIZE < static_cast<int>(this->meta.size())) {
+		for (address = start & ~(LINE_SIZE - 1); address < end; address += LINE_SIZE) {
+			this->get_fields(WRAP_ADDRESS(address), &tag, &index, &offset);
+			index = this->search_ways_for(index, tag);
+			if (this->meta[index][0] == tag && (filter == VALID_LINES || this->meta[index][1] >= 0))
+				this->batch.push_back(index);
+		}
+		return;
+	}
+
+	for (CacheLine line : this->lines(filter))
+		if (line.address + LINE_SIZE > start && line.address < end)
+			this->batch.push_back(line.index);
+}
+
 int
 Cache::priming_address(int address)
 {
 	int tag, index, offset, t_index;
-	int r1, r2;
-	std::array<signed int, LINE_SIZE> *evict;
+	int r1;
 	std::array<int, 3> *meta;
 
 	r1 = 0;
-	GET_FIELDS(address, &tag, &index, &offset);
+	this->get_fields(address, &tag, &index, &offset);
 	t_index = this->search_ways_for(index, tag);
 	meta = &this->meta.at(t_index);
 
 	if (meta->at(0) != tag) {
 		r1 = 1;
+		// the victim is still being filled
+		if (t_index == this->stream_index)
+			return r1;
+
+		if (!this->missed) {
+			this->missed = 1;
+			TRACE(MISS, address);
+		}
 
-		evict = &this->data->at(t_index);
-
-		// handle eviction of dirty cache lines
-		if (meta->at(1) >= 0) {
-			r2 = this->lower->write_line(
-				this, *evict, ((index << LINE_SPEC) + (meta->at(0) << (this->size - this->ways + LINE_SPEC))));
-			if (r2)
-				meta->at(1) = -1;
-		} else {
-			r2 = this->lower->read_line(this, address, *evict);
-			if (r2) {
-				meta->at(0) = tag;
+		if (this->evict_line(t_index) && this->fill(address, t_index)) {
+			this->set_tag(t_index, tag);
+			this->filled = 1;
+			if (!this->owner.empty())
+				this->owner.at(t_index) = this->active;
+			if (this->tag_spec) {
+				this->csize.at(t_index) = compressed_size(this->data->at(t_index));
+				this->stats[COMPRESSED_BYTES] += this->csize.at(t_index);
+				this->stats[UNCOMPRESSED_BYTES] += LINE_SIZE * sizeof(signed int);
 			}
 		}
-	}
+	} else if (this->sector_spec && this->expand(this->access_mask) & ~this->valid_words.at(t_index)) {
+		r1 = 1;
+		if (!this->missed) {
+			this->missed = 1;
+			TRACE(MISS, address);
+			++this->stats[SECTOR_MISSES];
+		}
+
+		if (this->fill(address, t_index))
+			this->filled = 1;
+	} else if (this->tag_spec)
+		r1 = this->make_room(index, t_index);
 
 	return r1;
 }
 
+int
+Cache::fill(int address, int t_index)
+{
+	unsigned int valid, words, s, last;
+
+	if (this->victim) {
+		// the line swapped in from above is placed whole
+		this->data->at(t_index) = *this->victim;
+		return 1;
+	}
+	// lines filled for non-temporal accesses are not worth keeping below either
+	if (!this->sector_spec && this->non_temporal)
+		return this->lower->read_words_non_temporal(
+			this, address, (1U << LINE_SIZE) - 1, this->data->at(t_index));
+	if (!this->sector_spec)
+		return this->lower->read_line(this, address, this->data->at(t_index));
+
+	valid = this->get_valid_words(t_index);
+	words = this->expand(this->access_mask);
+	// fetch the sectors following the last one needed
+	last = std::bit_width(words) >> (LINE_SPEC - this->sector_spec);
+	for (s = last; s < last + this->neighbors && s < 1U << this->sector_spec; ++s)
+		words |= this->expand(1U << (s << (LINE_SPEC - this->sector_spec)));
+	words &= ~valid;
+
+	if (this->non_temporal
+			? !this->lower->read_words_non_temporal(this, address, words, this->data->at(t_index))
+			: !this->lower->read_words(this, address, words, this->data->at(t_index)))
+		return 0;
+
+	if (this->meta.at(t_index).at(0) < 0)
+		this->dirty_words.at(t_index) = 0;
+	this->valid_words.at(t_index) = valid | words;
+	this->stats[FILL_WORDS_SAVED] += LINE_SIZE - std::popcount(words);
+	return 1;
+}
+
+int
+Cache::write_back(int t_index, int address)
+{
+	unsigned int words;
+
+	if (!this->sector_spec) {
+		if (!this->lower->write_victim(
+				this, this->data->at(t_index), address, this->meta.at(t_index).at(1) >= 0))
+			return 0;
+	} else {
+		words = this->written_words(t_index);
+		if (!this->lower->write_words(this, this->data->at(t_index), address, words))
+			return 0;
+		this->dirty_words.at(t_index) = 0;
+		this->stats[WRITEBACK_WORDS_SAVED] += LINE_SIZE - std::popcount(words);
+	}
+
+	this->meta.at(t_index).at(1) = -1;
+	return 1;
+}
+
+unsigned int
+Cache::written_words(int t_index) const
+{
+	if (!this->sector_spec)
+		return (1U << LINE_SIZE) - 1;
+	return this->meta.at(t_index).at(1) >= 0 && this->lower->get_inclusion() != EXCLUSIVE
+			   ? this->dirty_words.at(t_index)
+			   : this->valid_words.at(t_index);
+}
+
+void
+Cache::mark_dirty(int t_index, unsigned int words)
+{
+	this->meta.at(t_index).at(1) = 1;
+	if (this->sector_spec)
+		this->dirty_words.at(t_index) |= words & this->valid_words.at(t_index);
+}
+
+unsigned int
+Cache::expand(unsigned int words) const
+{
+	unsigned int sector, r;
+	int s;
+
+	sector = (1U << (LINE_SIZE >> this->sector_spec)) - 1;
+	r = 0;
+	for (s = 0; s < LINE_SIZE; s += LINE_SIZE >> this->sector_spec)
+		if (words >> s & sector)
+			r |= sector << s;
+	return r;
+}
+
+int
+Cache::evict_line(int t_index)
+{
+	int victim;
+	std::array<signed int, LINE_SIZE> *evict;
+	std::array<int, 3> *meta;
+
+	meta = &this->meta.at(t_index);
+	if (meta->at(0) < 0) {
+		this->evicting = 0;
+		return 1;
+	}
+
+	evict = &this->data->at(t_index);
+	victim = this->line_address(t_index);
+	if (!this->evicting) {
+		this->evicting = 1;
+		TRACE(EVICT, victim);
+		++this->stats[EVICTIONS];
+		if (!this->prefetched.empty() && this->prefetched.erase(victim >> LINE_SPEC))
+			++this->stats[USELESS_PREFETCHES];
+		// dirty copies above this level are newer than `evict'
+		if (this->inclusion == INCLUSIVE && this->invalidate_uppers(victim, *evict) == 2)
+			this->mark_dirty(t_index, (1U << LINE_SIZE) - 1);
+	}
+
+	// handle eviction of dirty cache lines, or of any valid line if `lower' is exclusive
+	if (meta->at(1) >= 0 || this->lower->get_inclusion() == EXCLUSIVE) {
+		if (this->write_back(t_index, victim)) {
+			this->clear_line(t_index);
+			this->evicting = 0;
+			TRACE(WRITEBACK, victim);
+			++this->stats[WRITEBACKS];
+		}
+		return 0;
+	}
+
+	this->clear_line(t_index);
+	this->evicting = 0;
+	return 1;
+}
+
+int
+Cache::line_address(int t_index) const
+{
+	int index;
+
+	if (this->indexing != MODULO)
+		return this->meta[t_index][0] << LINE_SPEC;
+
+	index = t_index >> (this->ways + this->tag_spec);
+	return (index << LINE_SPEC) + (this->meta[t_index][0] << (this->size - this->ways + LINE_SPEC));
+}
+
+void
+Cache::get_fields(int address, int *tag, int *index, int *offset) const
+{
+	GET_FIELDS(address, tag, index, offset);
+	if (this->indexing != MODULO) {
+		// the set no longer determines any bits of the address
+		*tag = address >> LINE_SPEC;
+		*index = this->hash_line(*tag, 0);
+	}
+}
+
+int
+Cache::hash_line(int line, int way) const
+{
+	int bits, sets, r, high;
+
+	bits = this->size - this->ways;
+	sets = 1 << bits;
+	if (bits == 0)
+		return 0;
+
+	switch (this->indexing) {
+	case XOR_FOLD:
+		for (r = 0; line; line >>= bits)
+			r ^= line & (sets - 1);
+		return r;
+	case PRIME_MODULO:
+		return line % this->prime;
+	case SKEWED:
+		way %= bits;
+		high = (line >> bits) & (sets - 1);
+		return (line ^ high << way ^ high >> (bits - way)) & (sets - 1);
+	default:
+		return line & (sets - 1);
+	}
+}
+
+int
+Cache::entry(int index, int tag, int i) const
+{
+	if (this->indexing == SKEWED)
+		index = this->hash_line(tag, i >> this->tag_spec);
+	return (index << (this->ways + this->tag_spec)) + i;
+}
+
+int
+Cache::make_room(int index, int t_index)
+{
+	int i, first, used, v;
+
+	first = index << (this->ways + this->tag_spec);
+	used = 0;
+	v = -1;
+	for (i = first; i < first + (1 << (this->ways + this->tag_spec)); ++i) {
+		if (this->meta.at(i).at(0) < 0)
+			continue;
+		used += this->csize.at(i);
+		if (i != t_index && (v < 0 || this->meta.at(i).at(2) < this->meta.at(v).at(2)))
+			v = i;
+	}
+
+	if (used <= static_cast<int>(LINE_SIZE * sizeof(signed int)) << this->ways)
+		return 0;
+
+	this->evict_line(v);
+	return 1;
+}
+
+int
+Cache::compressed_size(const std::array<signed int, LINE_SIZE> &line)
+{
+	int i, zero, repeat;
+	long delta, widest;
+
+	zero = repeat = 1;
+	widest = 0;
+	for (i = 0; i < LINE_SIZE; ++i) {
+		zero &= line[i] == 0;
+		repeat &= line[i] == line[0];
+		delta = static_cast<long>(line[i]) - line[0];
+		widest = std::max(widest, delta < 0 ? -delta - 1 : delta);
+	}
+
+	if (zero)
+		return 1;
+	if (repeat)
+		return sizeof(signed int);
+	// base followed by one or two byte deltas
+	if (widest < (1 << 7))
+		return sizeof(signed int) + LINE_SIZE;
+	if (widest < (1 << 15))
+		return sizeof(signed int) + 2 * LINE_SIZE;
+	return LINE_SIZE * sizeof(signed int);
+}
+
+int
+Cache::is_decompressing(int index)
+{
+	int size;
+
+	if (!this->tag_spec)
+		return 0;
+
+	if (!this->charged) {
+		this->charged = 1;
+		size = this->csize.at(index);
+		// fills arrive uncompressed; zero, repeated and uncompressed lines are read out directly
+		if (!this->missed && size != 1 && size != sizeof(signed int) &&
+			size != LINE_SIZE * sizeof(signed int)) {
+			this->penalty = this->decompress_delay;
+			this->stats[DECOMPRESSION_CYCLES] += this->penalty;
+		}
+	}
+
+	if (this->penalty > 0) {
+		--this->penalty;
+		return 1;
+	}
+	return 0;
+}
+
+double
+Cache::get_compression_ratio() const
+{
+	unsigned long i, lines, bytes;
+
+	lines = bytes = 0;
+	for (i = 0; i < this->meta.size(); ++i) {
+		if (this->meta[i][0] < 0)
+			continue;
+		++lines;
+		bytes += this->tag_spec ? this->csize[i] : LINE_SIZE * sizeof(signed int);
+	}
+
+	return bytes ? static_cast<double>(lines * LINE_SIZE * sizeof(signed int)) / bytes : 1.0;
+}
+
 int
 Cache::search_ways_for(int index, int tag)
 {
-	int i, r;
+	int i, r, t;
+
+	// tags hold the whole line address unless indexing is MODULO
+	r = this->find_line(this->indexing == MODULO ? (tag << (this->size - this->ways)) + index : tag);
+	if (r >= 0)
+		return r;
+	if (this->partitions.empty() && this->indexing != SKEWED)
+		return this->least_recent(index);
+
+	r = -1;
+	for (i = 0; i < (1 << (this->ways + this->tag_spec)); ++i) {
+		t = this->entry(index, tag, i);
+		if ((this->partitions.empty() ||
+			 this->partitions[this->active].ways[i >> this->tag_spec]) &&
+			(r < 0 || this->meta.at(t).at(2) < this->meta.at(r).at(2)))
+			r = t;
+	}
+	return r;
+}
+
+void
+Cache::set_tag(int t_index, int tag)
+{
+	unsigned int slot, next, home, mask;
 
-	index = index * (1 << this->ways);
-	r = INT_MAX;
+	mask = this->lookup.size() - 1;
+	if (this->meta.at(t_index).at(0) >= 0) {
+		slot = this->hash_key(this->line_address(t_index) >> LINE_SPEC);
+		while (this->lookup[slot][1] != t_index)
+			slot = (slot + 1) & mask;
+		// move back each following entry whose probe would otherwise stop at the freed slot
+		for (next = (slot + 1) & mask; this->lookup[next][0] >= 0; next = (next + 1) & mask) {
+			home = this->hash_key(this->lookup[next][0]);
+			if (((next - home) & mask) >= ((next - slot) & mask)) {
+				this->lookup[slot] = this->lookup[next];
+				slot = next;
+			}
+		}
+		this->lookup[slot] = {-1, -1};
+	}
+
+	this->meta[t_index][0] = tag;
+	if (tag < 0)
+		return;
+	slot = this->hash_key(this->line_address(t_index) >> LINE_SPEC);
+	while (this->lookup[slot][0] >= 0)
+		slot = (slot + 1) & mask;
+	this->lookup[slot] = {this->line_address(t_index) >> LINE_SPEC, t_index};
+}
+
+void
+Cache::set_usage(int t_index, int usage)
+{
+	int set, i, p, n;
+	std::uint64_t *word;
 
-	for (i = 0; i < (1 << this->ways); ++i)
-		if (this->meta.at(index + i).at(0) == tag)
-			return i + index;
-	for (i = 0; i < (1 << this->ways); ++i)
-		if (this->meta.at(index + i).at(2) < r)
-			r = i;
-	return r + index;
+	set = t_index >> (this->ways + this->tag_spec);
+	i = t_index & ((1 << (this->ways + this->tag_spec)) - 1);
+	word = &this->unused.at(set * this->unused_words + i / 64);
+
+	if (this->meta.at(t_index).at(2) >= 0) {
+		p = this->lru_prev[t_index];
+		n = this->lru_next[t_index];
+		(p < 0 ? this->lru_head[set] : this->lru_next[p]) = n;
+		(n < 0 ? this->lru_tail[set] : this->lru_prev[n]) = p;
+	} else
+		*word &= ~(std::uint64_t(1) << i % 64);
+
+	this->meta[t_index][2] = usage;
+	if (usage < 0) {
+		*word |= std::uint64_t(1) << i % 64;
+		return;
+	}
+	// access numbers only increase, so the most recently used is always last
+	p = this->lru_tail[set];
+	this->lru_prev[t_index] = p;
+	this->lru_next[t_index] = -1;
+	(p < 0 ? this->lru_head[set] : this->lru_next[p]) = t_index;
+	this->lru_tail[set] = t_index;
+}
+
+void
+Cache::clear_line(int t_index)
+{
+	this->set_tag(t_index, -1);
+	this->meta[t_index][1] = -1;
+	this->set_usage(t_index, -1);
+}
+
+int
+Cache::find_line(int line) const
+{
+	unsigned int slot;
+
+	for (slot = this->hash_key(line); this->lookup[slot][0] >= 0;
+		 slot = (slot + 1) & (this->lookup.size() - 1))
+		if (this->lookup[slot][0] == line)
+			return this->lookup[slot][1];
+	return -1;
+}
+
+unsigned int
+Cache::hash_key(int line) const
+{
+	// Fibonacci hashing, taking the high bits of the product
+	return static_cast<std::uint32_t>(line * 2654435769U) >> this->lookup_shift;
+}
+
+int
+Cache::least_recent(int set) const
+{
+	int w;
+	std::uint64_t bits;
+
+	for (w = 0; w < this->unused_words; ++w) {
+		bits = this->unused[set * this->unused_words + w];
+		if (bits)
+			return (set << (this->ways + this->tag_spec)) + w * 64 + std::countr_zero(bits);
+	}
+	return this->lru_head[set];
+}
+
+void
+Cache::rebuild_lookup()
+{
+	int entries, bits, i, tag, usage;
+	std::vector<int> order;
+
+	entries = this->meta.size();
+	// at most half full, so probes stay short
+	bits = std::bit_width(static_cast<unsigned int>(entries));
+	this->lookup.assign(1U << bits, {-1, -1});
+	this->lookup_shift = 32 - bits;
+	this->lru_prev.assign(entries, -1);
+	this->lru_next.assign(entries, -1);
+	this->lru_head.assign(entries >> (this->ways + this->tag_spec), -1);
+	this->lru_tail.assign(entries >> (this->ways + this->tag_spec), -1);
+	this->unused_words = ((1 << (this->ways + this->tag_spec)) + 63) / 64;
+	this->unused.assign(this->lru_head.size() * this->unused_words, 0);
+
+	for (i = 0; i < entries; ++i) {
+		tag = this->meta[i][0];
+		this->meta[i][0] = -1;
+		this->set_tag(i, tag);
+		order.push_back(i);
+	}
+
+	// relink in order of use, so the most recently used of each set is last
+	std::stable_sort(order.begin(), order.end(),
+					 [this](int a, int b) { return this->meta[a][2] < this->meta[b][2]; });
+	for (i = 0; i < entries; ++i) {
+		usage = this->meta[order[i]][2];
+		this->meta[order[i]][2] = -1;
+		this->set_usage(order[i], usage);
+	}
 }
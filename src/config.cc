@@ -0,0 +1,302 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "config.h"
+#include "bus.h"
+#include "cache.h"
+#include "dram.h"
+#include "icache.h"
+#include "router.h"
+#include "scratchpad.h"
+#include "store_buffer.h"
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @param the line number of `line'
+ * @param the line to parse
+ * @param set to the options given on `line'
+ * @return the kind of level named on `line', or an empty string if there is none
+ */
+static std::string
+parse_line(int number, std::string line, std::map<std::string, std::string> &options)
+{
+	std::istringstream words(line.substr(0, line.find('#')));
+	std::string kind, word;
+	size_t eq;
+
+	words >> kind;
+	while (words >> word) {
+		eq = word.find('=');
+		if (eq == std::string::npos || eq == 0)
+			throw std::invalid_argument(
+				"Line " + std::to_string(number) + ": expected key=value, got '" + word + "'.");
+		options[word.substr(0, eq)] = word.substr(eq + 1);
+	}
+
+	return kind;
+}
+
+/**
+ * Removes `key' from `options' and parses its value as one or more comma separated integers.
+ * @param the line number being parsed
+ * @param the options given on that line
+ * @param the option to take
+ * @param the number of integers expected
+ * @param the value to use if `key' is not given, or nullptr if it is required
+ * @return the integers
+ */
+static std::vector<int>
+take(int number,
+	 std::map<std::string, std::string> &options,
+	 const std::string &key,
+	 unsigned int count,
+	 const char *fallback)
+{
+	std::vector<int> r;
+	std::string value, item;
+	size_t used;
+	int ok;
+
+	if (options.count(key)) {
+		value = options[key];
+		options.erase(key);
+	} else if (fallback)
+		value = fallback;
+	else
+		throw std::invalid_argument(
+			"Line " + std::to_string(number) + ": missing option '" + key + "'.");
+
+	std::istringstream items(value);
+	ok = 1;
+	while (ok && std::getline(items, item, ',')) {
+		try {
+			r.push_back(std::stoi(item, &used, 0));
+			ok = used == item.size();
+		} catch (const std::logic_error &) {
+			ok = 0;
+		}
+	}
+	if (!ok || r.size() != count)
+		throw std::invalid_argument(
+			"Line " + std::to_string(number) + ": bad value for '" + key + "': '" + value + "'.");
+
+	return r;
+}
+
+/**
+ * @param the line number being parsed
+ * @param the value of an `arbitration' option
+ * @return the policy named
+ */
+static enum Arbitration
+parse_arbitration(int number, const std::string &value)
+{
+	if (value == "first-come")
+		return FIRST_COME;
+	if (value == "round-robin")
+		return ROUND_ROBIN;
+	if (value == "priority")
+		return PRIORITY;
+	if (value == "oldest")
+		return OLDEST;
+	throw std::invalid_argument(
+		"Line " + std::to_string(number) + ": unknown arbitration policy '" + value + "'.");
+}
+
+/**
+ * @param the line number being parsed
+ * @param the value of an `inclusion' option
+ * @return the policy named
+ */
+static enum Inclusion
+parse_inclusion(int number, const std::string &value)
+{
+	if (value == "non-inclusive")
+		return NON_INCLUSIVE;
+	if (value == "inclusive")
+		return INCLUSIVE;
+	if (value == "exclusive")
+		return EXCLUSIVE;
+	throw std::invalid_argument(
+		"Line " + std::to_string(number) + ": unknown inclusion policy '" + value + "'.");
+}
+
+/**
+ * @param the line number being parsed
+ * @param the value of an `index' option
+ * @return the index function named
+ */
+static enum Indexing
+parse_indexing(int number, const std::string &value)
+{
+	if (value == "modulo")
+		return MODULO;
+	if (value == "xor")
+		return XOR_FOLD;
+	if (value == "prime")
+		return PRIME_MODULO;
+	if (value == "skewed")
+		return SKEWED;
+	throw std::invalid_argument(
+		"Line " + std::to_string(number) + ": unknown index function '" + value + "'.");
+}
+
+Storage *
+build_hierarchy(std::istream &config, Topology &topology)
+{
+	std::map<std::string, std::string> options;
+	std::vector<int> v;
+	std::string line, kind, name;
+	Storage *top, *below, *level;
+	Cache *cache;
+	Scratchpad *scratchpad;
+	int number;
+
+	top = nullptr;
+	topology.clear();
+	for (number = 1; std::getline(config, line); ++number) {
+		options.clear();
+		try {
+			kind = parse_line(number, line, options);
+			if (kind.empty())
+				continue;
+
+			name = kind + std::to_string(topology.get_levels().size());
+			if (options.count("name")) {
+				name = options["name"];
+				options.erase("name");
+			}
+			if (topology.find(name))
+				throw std::invalid_argument(
+					"Line " + std::to_string(number) + ": level '" + name + "' already exists.");
+
+			if ((kind == "dram") != (top == nullptr))
+				throw std::invalid_argument(
+					"Line " + std::to_string(number) +
+					": the first level, and only the first, must be dram.");
+
+			below = top;
+			if (kind != "dram" && kind != "scratchpad" && options.count("lower")) {
+				below = topology.find(options["lower"]);
+				if (!below)
+					throw std::invalid_argument(
+						"Line " + std::to_string(number) + ": unknown level '" +
+						options["lower"] + "'.");
+				options.erase("lower");
+			}
+
+			if (kind == "dram") {
+				level = topology.add(name, new Dram(take(number, options, "delay", 1, nullptr)[0]));
+			} else if (kind == "bus") {
+				v = take(number, options, "width", 1, nullptr);
+				level = topology.add(
+					name, new Bus(below, v[0], take(number, options, "ratio", 1, "1")[0]));
+			} else if (kind == "icache") {
+				v = take(number, options, "size", 1, nullptr);
+				v.push_back(take(number, options, "ways", 1, "0")[0]);
+				v.push_back(take(number, options, "delay", 1, nullptr)[0]);
+				if (v[0] < 0 || v[1] < 0 || v[1] > v[0])
+					throw std::invalid_argument(
+						"Line " + std::to_string(number) + ": bad cache geometry.");
+				level = topology.add(name, new ICache(below, v[0], v[1], v[2]));
+			} else if (kind == "cache") {
+				v = take(number, options, "size", 1, nullptr);
+				v.push_back(take(number, options, "ways", 1, "0")[0]);
+				v.push_back(take(number, options, "delay", 1, nullptr)[0]);
+				if (v[0] < 0 || v[1] < 0 || v[1] > v[0])
+					throw std::invalid_argument(
+						"Line " + std::to_string(number) + ": bad cache geometry.");
+				level = cache = new Cache(below, v[0], v[1], v[2]);
+				topology.add(name, cache);
+
+				if (options.count("inclusion")) {
+					cache->set_inclusion(parse_inclusion(number, options["inclusion"]));
+					options.erase("inclusion");
+				}
+				if (options.count("index")) {
+					cache->set_indexing(parse_indexing(number, options["index"]));
+					options.erase("index");
+				}
+				cache->set_critical_word_first(take(number, options, "cwf", 1, "0")[0]);
+				cache->set_miss_classification(take(number, options, "classify", 1, "0")[0]);
+				if (options.count("predict")) {
+					v = take(number, options, "predict", 2, nullptr);
+					cache->set_way_prediction(v[0], v[1]);
+				}
+				if (options.count("compress")) {
+					v = take(number, options, "compress", 2, nullptr);
+					cache->set_compression(v[0], v[1]);
+				}
+				if (options.count("sectors")) {
+					v = take(number, options, "sectors", 2, nullptr);
+					if (v[0] < 0 || v[1] < 0)
+						throw std::invalid_argument(
+							"Line " + std::to_string(number) + ": bad sector count.");
+					cache->set_sectors(v[0], v[1]);
+				}
+			} else if (kind == "scratchpad") {
+				v = take(number, options, "base", 1, nullptr);
+				v.push_back(take(number, options, "lines", 1, nullptr)[0]);
+				v.push_back(take(number, options, "delay", 1, nullptr)[0]);
+				level = topology.add(name, new Scratchpad(v[0], v[1], v[2]));
+			} else if (kind == "router") {
+				scratchpad = nullptr;
+				if (options.count("scratchpad")) {
+					scratchpad = dynamic_cast<Scratchpad *>(topology.find(options["scratchpad"]));
+					options.erase("scratchpad");
+				}
+				if (!scratchpad)
+					throw std::invalid_argument(
+						"Line " + std::to_string(number) + ": expected 'scratchpad' to name a "
+						"scratchpad.");
+				level = topology.add(name, new Router(below, scratchpad));
+			} else if (kind == "storebuffer") {
+				level = topology.add(
+					name, new StoreBuffer(below, take(number, options, "entries", 1, nullptr)[0]));
+			} else
+				throw std::invalid_argument(
+					"Line " + std::to_string(number) + ": unknown level '" + kind + "'.");
+
+			// a scratchpad is reached through routers, so is never built over by default
+			if (kind != "scratchpad")
+				top = level;
+
+			if (options.count("arbitration")) {
+				v = take(number, options, "queue", 1, "0");
+				if (v[0] < 0)
+					throw std::invalid_argument(
+						"Line " + std::to_string(number) + ": bad queue depth.");
+				level->set_arbitration(parse_arbitration(number, options["arbitration"]), v[0]);
+				options.erase("arbitration");
+			}
+
+			if (!options.empty())
+				throw std::invalid_argument(
+					"Line " + std::to_string(number) + ": unknown option '" +
+					options.begin()->first + "'.");
+		} catch (const std::invalid_argument &) {
+			topology.clear();
+			throw;
+		}
+	}
+
+	if (top == nullptr)
+		throw std::invalid_argument("Config has no levels.");
+	return top;
+}
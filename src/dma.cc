@@ -0,0 +1,165 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "dma.h"
+#include "definitions.h"
+#include <stdexcept>
+
+Dma::Dma(Storage *target, int coherent, int depth)
+{
+	if (depth < 1)
+		throw std::invalid_argument("DMA buffer depth must be positive.");
+
+	this->target = target;
+	this->coherent = coherent;
+	this->depth = depth;
+	this->src = -1;
+	this->dst = 0;
+	this->n_lines = 0;
+	this->read_next = 0;
+	this->write_next = 0;
+	this->reading = 0;
+	this->writing = 0;
+	this->incoming = {};
+	this->cycles = 0;
+	this->last_cycles = 0;
+	this->last_lines = 0;
+}
+
+int
+Dma::copy_block(int src, int dst, int n_lines)
+{
+	if (this->is_busy())
+		return 0;
+	if (src < dst + n_lines * LINE_SIZE && dst < src + n_lines * LINE_SIZE)
+		throw std::invalid_argument("DMA source and destination overlap.");
+
+	this->src = src;
+	this->dst = dst;
+	this->n_lines = n_lines;
+	this->read_next = 0;
+	this->write_next = 0;
+	this->cycles = 0;
+	return 1;
+}
+
+int
+Dma::fill_block(int dst, std::array<signed int, LINE_SIZE> data_line, int n_lines)
+{
+	int i;
+
+	if (this->is_busy())
+		return 0;
+
+	this->src = -1;
+	this->dst = dst;
+	this->n_lines = n_lines;
+	this->read_next = n_lines;
+	this->write_next = 0;
+	this->cycles = 0;
+	this->buffer.clear();
+	for (i = 0; i < n_lines; ++i)
+		this->buffer.push_back(data_line);
+	return 1;
+}
+
+int
+Dma::tick()
+{
+	if (!this->is_busy())
+		return 1;
+
+	++this->cycles;
+	this->advance_write();
+	this->advance_read();
+
+	if (this->is_busy())
+		return 0;
+
+	this->last_cycles = this->cycles;
+	this->last_lines = this->n_lines;
+	return 1;
+}
+
+int
+Dma::is_busy() const { return this->write_next < this->n_lines; }
+
+double
+Dma::get_bandwidth() const
+{
+	return this->last_cycles
+			   ? static_cast<double>(this->last_lines * LINE_SIZE) / this->last_cycles
+			   : 0.0;
+}
+
+unsigned long
+Dma::get_cycles() const { return this->last_cycles; }
+
+void
+Dma::advance_read()
+{
+	int address;
+
+	if (!this->reading &&
+		(this->read_next >= this->n_lines || static_cast<int>(this->buffer.size()) >= this->depth))
+		return;
+
+	address = this->src + this->read_next * LINE_SIZE;
+	if (!this->reading)
+		this->reading = 1;
+
+	if (this->reading == 1) {
+		if (!this->target->read_line(&this->reader, address, this->incoming))
+			return;
+		// copies above `target' are newer, though they may hold only some of the line's words,
+		// and a dirty one must reach `target' before the line moves on
+		if (this->coherent && this->target->invalidate_uppers(address, this->incoming) == 2)
+			this->reading = 2;
+	}
+
+	if (this->reading == 2 && !this->target->write_line(&this->reader, this->incoming, address))
+		return;
+
+	this->buffer.push_back(this->incoming);
+	this->reading = 0;
+	++this->read_next;
+}
+
+void
+Dma::advance_write()
+{
+	int address;
+	std::array<signed int, LINE_SIZE> stale;
+
+	if (this->buffer.empty())
+		return;
+
+	address = this->dst + this->write_next * LINE_SIZE;
+	if (!this->writing) {
+		this->writing = 1;
+		// copies above `target' are about to be overwritten
+		if (this->coherent)
+			this->target->invalidate_uppers(address, stale);
+	}
+
+	if (!this->target->write_line(&this->writer, this->buffer.front(), address))
+		return;
+
+	this->buffer.pop_front();
+	this->writing = 0;
+	++this->write_next;
+}
@@ -50,6 +50,49 @@ Dram::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_l
 	});
 }
 
+int
+Dram::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	return process(id, address, [&](int line, int word) {
+		for (word = 0; word < LINE_SIZE; ++word)
+			if (mask >> word & 1)
+				this->data->at(line).at(word) = data_line[word];
+	});
+}
+
+int
+Dram::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int line, int word) {
+		for (word = 0; word < LINE_SIZE; ++word)
+			if (mask >> word & 1)
+				data_line[word] = this->data->at(line).at(word);
+	});
+}
+
+int
+Dram::write_lines(void *id, const std::vector<LineWrite> &lines)
+{
+	int line, word;
+
+	if (lines.empty())
+		return 1;
+	if (!preprocess(id, lines.front().address))
+		return 0;
+	if (this->elapsed == 1)
+		this->wait_time += lines.size() - 1;
+	if (!this->is_data_ready())
+		return 0;
+
+	for (const LineWrite &l : lines) {
+		get_memory_index(l.address, line, word);
+		for (word = 0; word < LINE_SIZE; ++word)
+			if (l.mask >> word & 1)
+				this->data->at(line).at(word) = l.data[word];
+	}
+	return 1;
+}
+
 int
 Dram::read_word(void *id, int address, signed int &data)
 {
@@ -71,7 +114,7 @@ Dram::load(std::vector<signed int> program)
 int
 Dram::process(void *id, int address, std::function<void(int line, int word)> request_handler)
 {
-	if (!preprocess(id) || !this->is_data_ready())
+	if (!preprocess(id, address) || !this->is_data_ready())
 		return 0;
 
 	int line, word;
@@ -0,0 +1,215 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "icache.h"
+#include "definitions.h"
+#include <climits>
+#include <stdexcept>
+
+ICache::ICache(Storage *lower, unsigned int size, unsigned int ways, int delay) : Storage(delay)
+{
+	if (ways > size)
+		throw std::invalid_argument("Cache cannot have more ways than lines.");
+
+	this->data->resize(1 << size);
+	this->tags.assign(1 << size, -1);
+	this->used.assign(1 << size, 0);
+	this->lower = lower;
+	this->size = size;
+	this->ways = ways;
+	this->access_num = 0;
+	this->missed = 0;
+	this->lower->add_upper(this);
+}
+
+ICache::~ICache()
+{
+	if (this->owns_lower)
+		delete this->lower;
+	delete this->data;
+}
+
+int
+ICache::write_word(void *id, signed int data, int address)
+{
+	(void)id;
+	(void)data;
+	(void)address;
+	throw std::invalid_argument("Instruction caches are read-only.");
+}
+
+int
+ICache::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	(void)data_line;
+	return this->write_word(id, 0, address);
+}
+
+int
+ICache::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	(void)data_line;
+	(void)mask;
+	return this->write_word(id, 0, address);
+}
+
+int
+ICache::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int index, int offset) {
+		(void)offset;
+		data_line = this->data->at(index);
+	});
+}
+
+int
+ICache::read_word(void *id, int address, signed int &data)
+{
+	return process(
+		id, address, [&](int index, int offset) { data = this->data->at(index).at(offset); });
+}
+
+int
+ICache::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int index, int offset) {
+		for (offset = 0; offset < LINE_SIZE; ++offset)
+			if (mask >> offset & 1)
+				data_line[offset] = this->data->at(index).at(offset);
+	});
+}
+
+int
+ICache::back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int index;
+
+	(void)data_line;
+	index = this->search_ways_for(address);
+	if (this->tags[index] != address >> (this->size - this->ways + LINE_SPEC))
+		return 0;
+	// never dirty, so `lower' already holds the same data
+	this->tags[index] = -1;
+	return 1;
+}
+
+int
+ICache::maintain(void *id, enum Maintenance op, int start, int end)
+{
+	int address, index;
+
+	if (!preprocess(id, start))
+		return 0;
+
+	++this->stats[MAINTENANCE_CYCLES];
+	if (op != CLEAN)
+		for (address = start & ~(LINE_SIZE - 1); address < end; address += LINE_SIZE) {
+			index = this->search_ways_for(WRAP_ADDRESS(address));
+			if (this->tags[index] ==
+				WRAP_ADDRESS(address) >> (this->size - this->ways + LINE_SPEC))
+				this->tags[index] = -1;
+		}
+
+	if (!this->lower->maintain(this, op, start, end) || !this->is_data_ready())
+		return 0;
+	return 1;
+}
+
+int
+ICache::get_tag(int index) const
+{
+	return this->tags.at(index);
+}
+
+int
+ICache::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+{
+	int index;
+
+	address = WRAP_ADDRESS(address);
+	if (!preprocess(id, address) || this->priming_address(address) || !this->is_data_ready())
+		return 0;
+
+	index = this->search_ways_for(address);
+	request_handler(index, GET_LS_BITS(address, LINE_SPEC));
+	this->used[index] = this->access_num++ % INT_MAX;
+	if (this->missed)
+		++this->stats[MISSES];
+	else {
+		TRACE(HIT, address);
+		++this->stats[HITS];
+	}
+	this->missed = 0;
+
+	return 1;
+}
+
+int
+ICache::priming_address(int address)
+{
+	int tag, index, victim;
+
+	tag = address >> (this->size - this->ways + LINE_SPEC);
+	index = this->search_ways_for(address);
+	if (this->tags[index] == tag)
+		return 0;
+
+	victim = (this->tags[index] << (this->size - this->ways + LINE_SPEC)) |
+			 (GET_MID_BITS(address, LINE_SPEC, this->size - this->ways + LINE_SPEC) << LINE_SPEC);
+	if (!this->missed) {
+		this->missed = 1;
+		TRACE(MISS, address);
+		if (this->tags[index] >= 0) {
+			TRACE(EVICT, victim);
+			++this->stats[EVICTIONS];
+		}
+	}
+
+	// exclusive levels below keep only what is swapped into them
+	if (this->tags[index] >= 0 && this->lower->get_inclusion() == EXCLUSIVE) {
+		if (this->lower->write_victim(this, this->data->at(index), victim, 0)) {
+			this->tags[index] = -1;
+			TRACE(WRITEBACK, victim);
+			++this->stats[WRITEBACKS];
+		}
+	} else if (this->lower->read_line(this, address, this->data->at(index)))
+		this->tags[index] = tag;
+
+	return 1;
+}
+
+int
+ICache::search_ways_for(int address) const
+{
+	int i, tag, set, r;
+
+	tag = address >> (this->size - this->ways + LINE_SPEC);
+	set = GET_MID_BITS(address, LINE_SPEC, this->size - this->ways + LINE_SPEC) << this->ways;
+	for (i = 0; i < 1 << this->ways; ++i)
+		if (this->tags[set + i] == tag)
+			return set + i;
+
+	// invalid entries are used first
+	r = set;
+	for (i = 0; i < 1 << this->ways; ++i) {
+		if (this->tags[set + i] < 0)
+			return set + i;
+		if (this->used[set + i] < this->used[r])
+			r = set + i;
+	}
+	return r;
+}
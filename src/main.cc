@@ -0,0 +1,173 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "config.h"
+#include "dma.h"
+#include "storage.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * The number of lines a DMA engine started by a workload buffers between reading and writing.
+ */
+#define DMA_DEPTH 4
+
+/**
+ * Issues each request in `workload' to `top', one after another, until it completes. Each line
+ * holds `r ADDRESS', `w ADDRESS DATA', their non-temporal forms `rn' and `wn', or
+ * `p ADDRESS LEVEL' to prefetch into the LEVELth cache, or `d SRC DST LINES' to start a DMA copy
+ * which proceeds alongside the requests after it, optionally preceded by `@NAME' to issue it to
+ * the level named NAME instead. Each level has one DMA engine, which a copy waits for if it is
+ * busy. Text after `#' is ignored.
+ * @param the hierarchy
+ * @param the level requests are issued to by default
+ * @param the requests to issue
+ * @param set to the number of requests issued
+ * @return the number of clock cycles taken
+ */
+static unsigned long
+run_workload(Topology &topology, Storage *top, std::istream &workload, unsigned long &requests)
+{
+	std::string line, op, extra;
+	std::map<Storage *, Dma> engines;
+	unsigned long cycles;
+	Storage *target;
+	signed int data;
+	int number, address, level, dst, lines, id, done;
+
+	cycles = 0;
+	requests = 0;
+	for (number = 1; std::getline(workload, line); ++number) {
+		std::istringstream words(line.substr(0, line.find('#')));
+		if (!(words >> op))
+			continue;
+
+		target = top;
+		if (op[0] == '@') {
+			target = topology.find(op.substr(1));
+			if (!target || !(words >> op))
+				throw std::invalid_argument(
+					"Workload line " + std::to_string(number) + ": expected a level and request.");
+		}
+
+		words >> std::setbase(0) >> address;
+		if (op == "w" || op == "wn")
+			words >> data;
+		else if (op == "p")
+			words >> level;
+		else if (op == "d")
+			words >> std::setbase(0) >> dst >> lines;
+		if (!words ||
+			(op != "r" && op != "w" && op != "rn" && op != "wn" && op != "p" && op != "d") ||
+			(words >> extra))
+			throw std::invalid_argument(
+				"Workload line " + std::to_string(number) + ": expected 'r ADDRESS', "
+				"'w ADDRESS DATA', 'rn ADDRESS', 'wn ADDRESS DATA', 'p ADDRESS LEVEL' or "
+				"'d SRC DST LINES'.");
+
+		do {
+			++cycles;
+			if (op == "r")
+				done = target->read_word(&id, address, data);
+			else if (op == "w")
+				done = target->write_word(&id, data, address);
+			else if (op == "rn")
+				done = target->read_word_non_temporal(&id, address, data);
+			else if (op == "wn")
+				done = target->write_word_non_temporal(&id, data, address);
+			else if (op == "p")
+				done = target->prefetch(&id, address, level);
+			else
+				done = engines.try_emplace(target, target, 0, DMA_DEPTH)
+						   .first->second.copy_block(address, dst, lines);
+			for (auto &engine : engines)
+				engine.second.tick();
+			topology.tick();
+		} while (!done);
+		++requests;
+	}
+
+	// let buffered work and transfers finish
+	while (!topology.fence(&id) || std::any_of(engines.begin(), engines.end(), [](auto &engine) {
+			   return engine.second.is_busy();
+		   })) {
+		++cycles;
+		for (auto &engine : engines)
+			engine.second.tick();
+		topology.tick();
+	}
+
+	return cycles;
+}
+
+int
+main(int argc, char **argv)
+{
+	Topology topology;
+	std::ifstream config, input;
+	unsigned long cycles, requests;
+	Storage *top;
+	int s;
+
+	if (argc < 2 || argc > 3) {
+		std::cerr << "usage: " << argv[0] << " CONFIG [WORKLOAD]" << std::endl;
+		return 2;
+	}
+
+	config.open(argv[1]);
+	if (!config) {
+		std::cerr << argv[0] << ": cannot open " << argv[1] << std::endl;
+		return 1;
+	}
+	if (argc == 3) {
+		input.open(argv[2]);
+		if (!input) {
+			std::cerr << argv[0] << ": cannot open " << argv[2] << std::endl;
+			return 1;
+		}
+	}
+
+	try {
+		top = build_hierarchy(config, topology);
+		cycles = run_workload(topology, top, argc == 3 ? input : std::cin, requests);
+	} catch (const std::exception &e) {
+		std::cerr << argv[0] << ": " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "requests " << requests << std::endl;
+	std::cout << "cycles " << cycles << std::endl;
+	for (const Level &level : topology.get_levels()) {
+		for (s = 0; s < STAT_COUNT; ++s)
+			if (level.storage->get_stat(static_cast<enum Stat>(s)))
+				std::cout << level.name << "." << Storage::stat_name(static_cast<enum Stat>(s))
+						  << " " << level.storage->get_stat(static_cast<enum Stat>(s))
+						  << std::endl;
+		if (level.storage->get_stat(REQUESTS))
+			for (int p : {50, 90, 99})
+				std::cout << level.name << ".latency_p" << p << " "
+						  << level.storage->get_latency_percentile(p / 100.0) << std::endl;
+	}
+
+	return 0;
+}
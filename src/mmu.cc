@@ -0,0 +1,298 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "mmu.h"
+#include "definitions.h"
+#include <climits>
+#include <stdexcept>
+
+Tlb::Tlb(unsigned int size, unsigned int ways, int delay)
+{
+	this->size = size;
+	this->ways = ways;
+	this->delay = delay;
+	this->access_num = 0;
+	this->entries = std::vector<std::array<signed int, 3>>(1 << size, {-1, -1, -1});
+}
+
+int
+Tlb::lookup(int vpn)
+{
+	int index;
+
+	index = this->search_ways_for(vpn);
+	if (this->entries[index][0] != vpn)
+		return -1;
+
+	this->entries[index][2] = this->access_num++ % INT_MAX;
+	return this->entries[index][1];
+}
+
+void
+Tlb::insert(int vpn, int ppn)
+{
+	int index;
+
+	index = this->search_ways_for(vpn);
+	this->entries[index] = {vpn, ppn, static_cast<signed int>(this->access_num++ % INT_MAX)};
+}
+
+void
+Tlb::flush()
+{
+	std::fill(this->entries.begin(), this->entries.end(), std::array<signed int, 3>{-1, -1, -1});
+}
+
+int
+Tlb::get_delay() const { return this->delay; }
+
+int
+Tlb::search_ways_for(int vpn)
+{
+	int i, index, r;
+
+	index = GET_LS_BITS(vpn, this->size - this->ways) << this->ways;
+	for (i = 0; i < (1 << this->ways); ++i)
+		if (this->entries[index + i][0] == vpn)
+			return index + i;
+
+	r = index;
+	for (i = 1; i < (1 << this->ways); ++i)
+		if (this->entries[index + i][2] < this->entries[r][2])
+			r = index + i;
+	return r;
+}
+
+Mmu::Mmu(
+	Storage *lower,
+	Tlb *l1,
+	Tlb *l2,
+	unsigned int page_spec,
+	unsigned int level_spec,
+	unsigned int levels,
+	int root)
+	: Storage(0)
+{
+	this->lower = lower;
+	this->l1 = l1;
+	this->l2 = l2;
+	this->page_spec = page_spec;
+	this->level_spec = level_spec;
+	this->levels = levels;
+	this->root = root;
+	this->phase = TLB_IDLE;
+	this->countdown = 0;
+	this->walk_level = 0;
+	this->walk_table = 0;
+	this->ppn = 0;
+	this->served = 0;
+	this->lower->add_upper(this);
+}
+
+Mmu::~Mmu()
+{
+	if (this->owns_lower)
+		delete this->lower;
+	delete this->l1;
+	delete this->l2;
+	delete this->data;
+}
+
+int
+Mmu::write_word(void *id, signed int data, int address)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->write_word(this, data, paddr);
+	});
+}
+
+int
+Mmu::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->write_line(this, data_line, paddr);
+	});
+}
+
+int
+Mmu::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->read_line(this, paddr, data_line);
+	});
+}
+
+int
+Mmu::read_word(void *id, int address, signed int &data)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->read_word(this, paddr, data);
+	});
+}
+
+int
+Mmu::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->write_words(this, data_line, paddr, mask);
+	});
+}
+
+int
+Mmu::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->read_words(this, paddr, mask, data_line);
+	});
+}
+
+int
+Mmu::read_word_non_temporal(void *id, int address, signed int &data)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->read_word_non_temporal(this, paddr, data);
+	});
+}
+
+int
+Mmu::write_word_non_temporal(void *id, signed int data, int address)
+{
+	return process(id, address, [&](int paddr, int offset) {
+		(void)offset;
+		this->served = this->lower->write_word_non_temporal(this, data, paddr);
+	});
+}
+
+int
+Mmu::prefetch(void *id, int address, int level)
+{
+	int ppn;
+
+	(void)id;
+	ppn = this->l1->lookup(
+		GET_MID_BITS(address, this->page_spec, this->page_spec + this->levels * this->level_spec));
+	if (ppn < 0)
+		return 1;
+	return this->lower->prefetch(
+		this, (ppn << this->page_spec) | GET_LS_BITS(address, this->page_spec), level);
+}
+
+void
+Mmu::flush_tlbs()
+{
+	this->l1->flush();
+	if (this->l2)
+		this->l2->flush();
+}
+
+int
+Mmu::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+{
+	int paddr;
+
+	if (!preprocess(id, address) || !this->translate(address, paddr))
+		return 0;
+
+	request_handler(paddr, 0);
+	if (!this->served)
+		return 0;
+
+	this->served = 0;
+	this->phase = TLB_IDLE;
+	this->release();
+	return 1;
+}
+
+int
+Mmu::translate(int address, int &paddr)
+{
+	int vpn, pte;
+
+	vpn = GET_MID_BITS(address, this->page_spec, this->page_spec + this->levels * this->level_spec);
+	switch (this->phase) {
+	case TLB_IDLE:
+		this->phase = TLB_L1;
+		this->countdown = this->l1->get_delay();
+		// fall through
+	case TLB_L1:
+		if (this->countdown-- > 0)
+			return 0;
+		this->ppn = this->l1->lookup(vpn);
+		if (this->ppn >= 0) {
+			this->phase = TLB_DONE;
+			break;
+		}
+		++this->stats[TLB_L1_MISSES];
+		this->phase = TLB_L2;
+		this->countdown = this->l2 ? this->l2->get_delay() : 0;
+		return 0;
+	case TLB_L2:
+		if (this->countdown-- > 0)
+			return 0;
+		this->ppn = this->l2 ? this->l2->lookup(vpn) : -1;
+		if (this->ppn >= 0) {
+			this->l1->insert(vpn, this->ppn);
+			this->phase = TLB_DONE;
+			break;
+		}
+		if (this->l2)
+			++this->stats[TLB_L2_MISSES];
+		++this->stats[WALKS];
+		this->phase = TLB_WALK;
+		this->walk_level = 0;
+		this->walk_table = this->root;
+		return 0;
+	case TLB_WALK:
+		++this->stats[WALK_CYCLES];
+		if (!this->lower->read_word(
+				this,
+				this->walk_table +
+					GET_MID_BITS(
+						vpn,
+						(this->levels - this->walk_level - 1) * this->level_spec,
+						(this->levels - this->walk_level) * this->level_spec),
+				pte))
+			return 0;
+		if (!PTE_VALID(pte)) {
+			this->phase = TLB_IDLE;
+			this->release();
+			throw std::out_of_range("Virtual address is not mapped.");
+		}
+		if (++this->walk_level < this->levels) {
+			this->walk_table = PTE_PAGE(pte) << this->page_spec;
+			return 0;
+		}
+		this->ppn = PTE_PAGE(pte);
+		this->l1->insert(vpn, this->ppn);
+		if (this->l2)
+			this->l2->insert(vpn, this->ppn);
+		this->phase = TLB_DONE;
+		return 0;
+	case TLB_DONE:
+		break;
+	}
+
+	paddr = (this->ppn << this->page_spec) | GET_LS_BITS(address, this->page_spec);
+	return 1;
+}
@@ -0,0 +1,141 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "router.h"
+#include "definitions.h"
+#include <stdexcept>
+
+Router::Router(Storage *lower, Scratchpad *scratchpad) : Storage(0)
+{
+	if (!scratchpad)
+		throw std::invalid_argument("Router requires a scratchpad.");
+
+	this->lower = lower;
+	this->scratchpad = scratchpad;
+	this->lower->add_upper(this);
+}
+
+Router::~Router()
+{
+	if (this->owns_lower)
+		delete this->lower;
+	delete this->data;
+}
+
+int
+Router::write_word(void *id, signed int data, int address)
+{
+	return this->route(address)->write_word(id, data, address);
+}
+
+int
+Router::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	return this->route(address)->write_line(id, data_line, address);
+}
+
+int
+Router::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->route(address)->read_line(id, address, data_line);
+}
+
+int
+Router::read_word(void *id, int address, signed int &data)
+{
+	return this->route(address)->read_word(id, address, data);
+}
+
+int
+Router::write_words(void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	return this->route(address)->write_words(id, data_line, address, mask);
+}
+
+int
+Router::write_victim(void *id, std::array<signed int, LINE_SIZE> data_line, int address, int dirty)
+{
+	return this->route(address)->write_victim(id, data_line, address, dirty);
+}
+
+int
+Router::read_words(void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->route(address)->read_words(id, address, mask, data_line);
+}
+
+int
+Router::read_word_non_temporal(void *id, int address, signed int &data)
+{
+	return this->route(address)->read_word_non_temporal(id, address, data);
+}
+
+int
+Router::read_words_non_temporal(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->route(address)->read_words_non_temporal(id, address, mask, data_line);
+}
+
+int
+Router::write_word_non_temporal(void *id, signed int data, int address)
+{
+	return this->route(address)->write_word_non_temporal(id, data, address);
+}
+
+int
+Router::back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->invalidate_uppers(address, data_line);
+}
+
+int
+Router::prefetch(void *id, int address, int level)
+{
+	if (this->scratchpad->contains(address))
+		return 1;
+	return this->lower->prefetch(id, address, level);
+}
+
+int
+Router::fence(void *id)
+{
+	(void)id;
+	return this->scratchpad->fence(this) & this->lower->fence(this);
+}
+
+enum Inclusion
+Router::get_inclusion() const
+{
+	return this->lower->get_inclusion();
+}
+
+int
+Router::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+{
+	(void)id;
+	request_handler(address, 0);
+	return 1;
+}
+
+Storage *
+Router::route(int address) const
+{
+	if (this->scratchpad->contains(address))
+		return this->scratchpad;
+	return this->lower;
+}
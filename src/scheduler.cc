@@ -0,0 +1,233 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "scheduler.h"
+#include <stdexcept>
+
+Scheduler::Task
+Scheduler::Task::promise_type::get_return_object()
+{
+	return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+Scheduler::Task::Task(std::coroutine_handle<promise_type> handle) { this->handle = handle; }
+
+Scheduler::Task::Task(Task &&other) noexcept
+{
+	this->handle = other.handle;
+	other.handle = nullptr;
+}
+
+Scheduler::Task::~Task()
+{
+	if (this->handle)
+		this->handle.destroy();
+}
+
+Scheduler::Access::Access(Scheduler *scheduler, Storage *storage, int address)
+{
+	this->scheduler = scheduler;
+	this->storage = storage;
+	this->address = address;
+}
+
+void
+Scheduler::Access::await_suspend(std::coroutine_handle<> handle)
+{
+	this->scheduler->issued.push_back({this, handle});
+}
+
+Scheduler::WordRead::WordRead(Scheduler *scheduler, Storage *storage, int address)
+	: Access(scheduler, storage, address)
+{
+	this->word = 0;
+}
+
+int
+Scheduler::WordRead::attempt(void *id)
+{
+	return this->storage->read_word(id, this->address, this->word);
+}
+
+Scheduler::LineRead::LineRead(Scheduler *scheduler, Storage *storage, int address)
+	: Access(scheduler, storage, address)
+{
+	this->line = {};
+}
+
+int
+Scheduler::LineRead::attempt(void *id)
+{
+	return this->storage->read_line(id, this->address, this->line);
+}
+
+Scheduler::WordWrite::WordWrite(Scheduler *scheduler, Storage *storage, signed int word, int address)
+	: Access(scheduler, storage, address)
+{
+	this->word = word;
+}
+
+int
+Scheduler::WordWrite::attempt(void *id)
+{
+	return this->storage->write_word(id, this->word, this->address);
+}
+
+Scheduler::LineWrite::LineWrite(
+	Scheduler *scheduler, Storage *storage, std::array<signed int, LINE_SIZE> line, int address)
+	: Access(scheduler, storage, address)
+{
+	this->line = line;
+}
+
+int
+Scheduler::LineWrite::attempt(void *id)
+{
+	return this->storage->write_line(id, this->line, this->address);
+}
+
+Scheduler::Sleep::Sleep(Scheduler *scheduler, int cycles) : Access(scheduler, nullptr, 0)
+{
+	if (cycles < 1)
+		throw std::invalid_argument("Tasks must sleep for at least one cycle.");
+	this->remaining = cycles;
+}
+
+int
+Scheduler::Sleep::attempt(void *id)
+{
+	(void)id;
+	return --this->remaining == 0;
+}
+
+Scheduler::Scheduler()
+{
+	this->cycle = 0;
+	this->tracer = nullptr;
+}
+
+Scheduler::~Scheduler()
+{
+	for (std::coroutine_handle<Task::promise_type> handle : this->tasks)
+		handle.destroy();
+}
+
+Scheduler::WordRead
+Scheduler::read_word(Storage &storage, int address)
+{
+	return WordRead(this, &storage, address);
+}
+
+Scheduler::LineRead
+Scheduler::read_line(Storage &storage, int address)
+{
+	return LineRead(this, &storage, address);
+}
+
+Scheduler::WordWrite
+Scheduler::write_word(Storage &storage, signed int data, int address)
+{
+	return WordWrite(this, &storage, data, address);
+}
+
+Scheduler::LineWrite
+Scheduler::write_line(Storage &storage, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	return LineWrite(this, &storage, data_line, address);
+}
+
+Scheduler::Sleep
+Scheduler::sleep(int cycles)
+{
+	return Sleep(this, cycles);
+}
+
+void
+Scheduler::spawn(Task task)
+{
+	task.handle.promise().slot = this->tasks.size();
+	this->tasks.push_back(task.handle);
+	this->starting.push_back(task.handle);
+	task.handle = nullptr;
+}
+
+unsigned long
+Scheduler::run()
+{
+	unsigned long begin, i, kept;
+
+	begin = this->cycle;
+	while (!this->tasks.empty()) {
+		++this->cycle;
+		if (this->tracer)
+			this->tracer->tick();
+
+		// tasks starting this cycle issue their first access this cycle
+		for (i = 0; i < this->starting.size(); ++i)
+			this->resume(this->starting[i]);
+		this->starting.clear();
+		this->pending.insert(this->pending.end(), this->issued.begin(), this->issued.end());
+		this->issued.clear();
+		if (this->pending.empty() && !this->tasks.empty())
+			throw std::logic_error("Tasks may only await accesses made through their scheduler.");
+
+		// accesses issued by resumed tasks wait for the next cycle, in `issued'
+		kept = 0;
+		for (i = 0; i < this->pending.size(); ++i) {
+			if (this->pending[i].first->attempt(this->pending[i].second.address()))
+				this->resume(this->pending[i].second);
+			else
+				this->pending[kept++] = this->pending[i];
+		}
+		this->pending.resize(kept);
+		this->pending.insert(this->pending.end(), this->issued.begin(), this->issued.end());
+		this->issued.clear();
+
+		for (Storage *storage : this->clocked)
+			storage->tick();
+	}
+
+	return this->cycle - begin;
+}
+
+unsigned long
+Scheduler::now() const { return this->cycle; }
+
+void
+Scheduler::attach(Storage &storage) { this->clocked.push_back(&storage); }
+
+void
+Scheduler::set_tracer(Tracer *tracer) { this->tracer = tracer; }
+
+void
+Scheduler::resume(std::coroutine_handle<> handle)
+{
+	std::coroutine_handle<Task::promise_type> task;
+	size_t slot;
+
+	handle.resume();
+	if (!handle.done())
+		return;
+
+	// move the last task into the returned task's slot
+	task = std::coroutine_handle<Task::promise_type>::from_address(handle.address());
+	slot = task.promise().slot;
+	this->tasks[slot] = this->tasks.back();
+	this->tasks[slot].promise().slot = slot;
+	this->tasks.pop_back();
+	task.destroy();
+}
@@ -0,0 +1,104 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "scratchpad.h"
+#include "definitions.h"
+#include <stdexcept>
+
+Scratchpad::Scratchpad(int base, int lines, int delay) : Storage(delay)
+{
+	if (base < 0 || base % LINE_SIZE || lines < 1 || lines > (MEM_WORDS - base) / LINE_SIZE)
+		throw std::invalid_argument("Scratchpad must be line aligned and lie within memory.");
+
+	this->data->resize(lines);
+	this->base = base;
+}
+
+Scratchpad::~Scratchpad() { delete this->data; }
+
+int
+Scratchpad::write_word(void *id, signed int data, int address)
+{
+	return process(id, address, [&](int line, int word) { this->data->at(line).at(word) = data; });
+}
+
+int
+Scratchpad::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	return process(id, address, [&](int line, int word) {
+		(void)word;
+		this->data->at(line) = data_line;
+	});
+}
+
+int
+Scratchpad::read_word(void *id, int address, signed int &data)
+{
+	return process(id, address, [&](int line, int word) { data = this->data->at(line).at(word); });
+}
+
+int
+Scratchpad::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int line, int word) {
+		(void)word;
+		data_line = this->data->at(line);
+	});
+}
+
+int
+Scratchpad::write_words(
+	void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	return process(id, address, [&](int line, int word) {
+		for (word = 0; word < LINE_SIZE; ++word)
+			if (mask >> word & 1)
+				this->data->at(line).at(word) = data_line[word];
+	});
+}
+
+int
+Scratchpad::read_words(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return process(id, address, [&](int line, int word) {
+		for (word = 0; word < LINE_SIZE; ++word)
+			if (mask >> word & 1)
+				data_line[word] = this->data->at(line).at(word);
+	});
+}
+
+int
+Scratchpad::contains(int address) const
+{
+	address = WRAP_ADDRESS(address);
+	return address >= this->base &&
+		   address < this->base + static_cast<int>(this->data->size()) * LINE_SIZE;
+}
+
+int
+Scratchpad::process(void *id, int address, std::function<void(int line, int word)> request_handler)
+{
+	if (!this->contains(address))
+		throw std::out_of_range("Address is outside the scratchpad.");
+	if (!preprocess(id, address) || !this->is_data_ready())
+		return 0;
+
+	address = WRAP_ADDRESS(address) - this->base;
+	request_handler(address / LINE_SIZE, address % LINE_SIZE);
+	return 1;
+}
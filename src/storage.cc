@@ -18,15 +18,60 @@
 #include "storage.h"
 #include "definitions.h"
 #include <algorithm>
+#include <bit>
 #include <stdexcept>
 
+LineView::LineView(const std::array<signed int, LINE_SIZE> *first, size_t count)
+{
+	this->first = first;
+	this->count = count;
+}
+
+const std::array<signed int, LINE_SIZE> *
+LineView::begin() const { return this->first; }
+
+const std::array<signed int, LINE_SIZE> *
+LineView::end() const { return this->first + this->count; }
+
+size_t
+LineView::size() const { return this->count; }
+
+const std::array<signed int, LINE_SIZE> &
+LineView::operator[](size_t i) const
+{
+	if (i >= this->count)
+		throw std::out_of_range("Line is outside of view.");
+	return this->first[i];
+}
+
 Storage::Storage(int delay)
 {
 	this->data = new std::vector<std::array<signed int, LINE_SIZE>>;
 	this->delay = delay;
 	this->lower = nullptr;
+	this->owns_lower = 1;
 	this->current_request = nullptr;
 	this->wait_time = this->delay;
+	this->elapsed = 0;
+	this->request_address = 0;
+	this->tracer = nullptr;
+	this->trace_level = 0;
+	this->inclusion = NON_INCLUSIVE;
+	this->stats.fill(0);
+	this->ledger = {0, {0}, {0}};
+	this->histogram.fill(0);
+	this->arbitration = FIRST_COME;
+	this->queue_depth = 0;
+	this->arrivals = 0;
+	this->last_granted = -1;
+}
+
+int
+Storage::back_invalidate(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	(void)address;
+	(void)data_line;
+	return 0;
 }
 
 std::vector<std::array<signed int, LINE_SIZE>>
@@ -36,15 +81,360 @@ Storage::get_data() const
 }
 
 int
-Storage::preprocess(void *id)
+Storage::write_victim(void *id, std::array<signed int, LINE_SIZE> data_line, int address, int dirty)
+{
+	return !dirty || this->write_line(id, data_line, address);
+}
+
+int
+Storage::write_lines(void *id, const std::vector<LineWrite> &lines)
+{
+	const LineWrite *l;
+	unsigned long &i = this->lines_written[id];
+
+	for (; i < lines.size(); ++i) {
+		l = &lines[i];
+		if (l->mask == (1U << LINE_SIZE) - 1 ? !this->write_line(id, l->data, l->address)
+											  : !this->write_words(id, l->data, l->address, l->mask))
+			return 0;
+	}
+
+	this->lines_written.erase(id);
+	return 1;
+}
+
+int
+Storage::maintain(void *id, enum Maintenance op, int start, int end)
+{
+	(void)id;
+	return this->lower ? this->lower->maintain(this, op, start, end) : 1;
+}
+
+int
+Storage::prefetch(void *id, int address, int level)
+{
+	(void)id;
+	return this->lower ? this->lower->prefetch(this, address, level) : 1;
+}
+
+int
+Storage::read_word_non_temporal(void *id, int address, signed int &data)
+{
+	return this->read_word(id, address, data);
+}
+
+int
+Storage::read_words_non_temporal(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data)
+{
+	return this->read_words(id, address, mask, data);
+}
+
+int
+Storage::write_word_non_temporal(void *id, signed int data, int address)
+{
+	return this->write_word(id, data, address);
+}
+
+int
+Storage::fence(void *id)
+{
+	if (this->current_request != nullptr && this->current_request != id)
+		return 0;
+	return this->lower ? this->lower->fence(this) : 1;
+}
+
+void
+Storage::tick()
+{
+	// shared levels are ticked by their owner
+	if (this->lower && this->owns_lower)
+		this->lower->tick();
+}
+
+int
+Storage::flush(void *id)
+{
+	return this->maintain(id, FLUSH, 0, MEM_WORDS);
+}
+
+int
+Storage::clean(void *id, int start, int end)
+{
+	return this->maintain(id, CLEAN, start, end);
+}
+
+int
+Storage::invalidate(void *id, int start, int end)
+{
+	return this->maintain(id, INVALIDATE, start, end);
+}
+
+const std::array<signed int, LINE_SIZE> &
+Storage::view_line(int index) const
+{
+	return this->data->at(index);
+}
+
+LineView
+Storage::view_lines(int first, int count) const
+{
+	if (first < 0 || count < 0 || static_cast<size_t>(first + count) > this->data->size())
+		throw std::out_of_range("Lines are outside of storage.");
+	return LineView(this->data->data() + first, count);
+}
+
+void
+Storage::add_upper(Storage *upper)
+{
+	this->uppers.push_back(upper);
+}
+
+Storage *
+Storage::get_lower() const
+{
+	return this->lower;
+}
+
+void
+Storage::share_lower() { this->owns_lower = 0; }
+
+enum Inclusion
+Storage::get_inclusion() const
+{
+	return this->inclusion;
+}
+
+void
+Storage::set_tracer(Tracer *tracer, const char *name)
+{
+	this->tracer = tracer;
+	if (tracer)
+		this->trace_level = tracer->attach(name);
+}
+
+void
+Storage::set_arbitration(enum Arbitration policy, unsigned int depth)
+{
+	this->arbitration = policy;
+	this->queue_depth = depth;
+}
+
+void
+Storage::set_priority(void *id, int priority)
+{
+	this->priorities[id] = priority;
+}
+
+unsigned long
+Storage::get_wait_cycles(void *id) const
+{
+	auto it = this->waits.find(id);
+	return it == this->waits.end() ? 0 : it->second;
+}
+
+const Ledger &
+Storage::get_ledger() const
+{
+	return this->ledger;
+}
+
+const std::array<unsigned long, LATENCY_BUCKETS> &
+Storage::get_latency_histogram() const
+{
+	return this->histogram;
+}
+
+unsigned long
+Storage::get_latency_percentile(double fraction) const
+{
+	unsigned long total, seen;
+	int b;
+
+	total = this->stats[REQUESTS];
+	if (!total)
+		return 0;
+
+	seen = 0;
+	for (b = 0; b < LATENCY_BUCKETS - 1; ++b) {
+		seen += this->histogram[b];
+		if (seen >= fraction * total)
+			break;
+	}
+	return b ? (1UL << b) - 1 : 0;
+}
+
+void
+Storage::absorb(const Ledger &below)
+{
+	unsigned long i;
+
+	if (this->ledger.service.size() < below.service.size() + 1) {
+		this->ledger.service.resize(below.service.size() + 1, 0);
+		this->ledger.contention.resize(below.service.size() + 1, 0);
+	}
+	for (i = 0; i < below.service.size(); ++i) {
+		this->ledger.service[i + 1] += below.service[i];
+		this->ledger.contention[i + 1] += below.contention[i];
+	}
+	this->ledger.hit_level = std::max(this->ledger.hit_level, below.hit_level + 1);
+	this->stats[LOWER_CYCLES] += below.service[0] + below.contention[0];
+}
+
+unsigned long
+Storage::get_stat(enum Stat s) const
+{
+	return this->stats.at(s);
+}
+
+const char *
+Storage::stat_name(enum Stat s)
+{
+	static const char *names[STAT_COUNT] = {
+		"hits",
+		"misses",
+		"evictions",
+		"writebacks",
+		"back_invalidations",
+		"loads",
+		"load_cycles",
+		"early_restarts",
+		"stream_stalls",
+		"tlb_l1_misses",
+		"tlb_l2_misses",
+		"walks",
+		"walk_cycles",
+		"compressed_bytes",
+		"uncompressed_bytes",
+		"decompression_cycles",
+		"maintenance_cycles",
+		"predicted_ways",
+		"mispredicted_ways",
+		"bus_busy_cycles",
+		"queue_cycles",
+		"queue_full",
+		"store_stalls",
+		"store_merges",
+		"store_forwards",
+		"compulsory_misses",
+		"capacity_misses",
+		"conflict_misses",
+		"sector_misses",
+		"fill_words_saved",
+		"writeback_words_saved",
+		"prefetches",
+		"useful_prefetches",
+		"useless_prefetches",
+		"bypasses",
+		"requests",
+		"latency_cycles",
+		"lower_cycles"};
+
+	return names[s];
+}
+
+int
+Storage::preprocess(void *id, int address)
 {
 	if (id == nullptr)
 		throw std::invalid_argument("Accessor cannot be nullptr.");
 
-	if (this->current_request == nullptr)
+	if (this->current_request == nullptr && this->arbitrate(id)) {
 		this->current_request = id;
+		this->elapsed = 0;
+		this->request_address = address;
+		this->ledger = {0, {0}, {this->refused[id]}};
+		this->refused.erase(id);
+		TRACE(ISSUE, address);
+	}
+	if (this->current_request != id) {
+		this->wait(id);
+		return 0;
+	}
+
+	++this->elapsed;
+	return 1;
+}
 
-	return this->current_request == id;
+int
+Storage::arbitrate(void *id)
+{
+	std::pair<void *, unsigned long> best;
+	unsigned long i, queued;
+
+	for (queued = 0; queued < this->queue.size() && this->queue[queued].first != id; ++queued)
+		;
+	if (this->arbitration != FIRST_COME) {
+		this->position(id);
+		// `id' competes as though it had just joined the queue
+		best = queued < this->queue.size() ? this->queue[queued]
+										   : std::make_pair(id, this->arrivals);
+		for (i = 0; i < this->queue.size(); ++i)
+			if (this->precedes(this->queue[i], best))
+				best = this->queue[i];
+		if (best.first != id)
+			return 0;
+	}
+
+	if (queued < this->queue.size())
+		this->queue.erase(this->queue.begin() + queued);
+	this->last_granted = this->position(id);
+	return 1;
+}
+
+int
+Storage::precedes(
+	const std::pair<void *, unsigned long> &a, const std::pair<void *, unsigned long> &b)
+{
+	int n, pa, pb;
+
+	switch (this->arbitration) {
+	case ROUND_ROBIN:
+		n = this->requesters.size();
+		pa = (this->position(a.first) - this->last_granted - 1 + n) % n;
+		pb = (this->position(b.first) - this->last_granted - 1 + n) % n;
+		return pa < pb;
+	case PRIORITY:
+		pa = this->priorities.count(a.first) ? this->priorities[a.first] : 0;
+		pb = this->priorities.count(b.first) ? this->priorities[b.first] : 0;
+		if (pa != pb)
+			return pa > pb;
+		return a.second < b.second;
+	default:
+		return a.second < b.second;
+	}
+}
+
+int
+Storage::position(void *id)
+{
+	int i;
+
+	i = std::find(this->requesters.begin(), this->requesters.end(), id) - this->requesters.begin();
+	if (i == static_cast<int>(this->requesters.size()))
+		this->requesters.push_back(id);
+	return i;
+}
+
+void
+Storage::wait(void *id)
+{
+	unsigned long i;
+
+	++this->stats[QUEUE_CYCLES];
+	++this->waits[id];
+	++this->refused[id];
+
+	for (i = 0; i < this->queue.size(); ++i)
+		if (this->queue[i].first == id)
+			return;
+
+	if (this->queue_depth && this->queue.size() >= this->queue_depth) {
+		++this->stats[QUEUE_FULL];
+		return;
+	}
+	this->position(id);
+	this->queue.push_back({id, this->arrivals++});
 }
 
 int
@@ -54,8 +444,7 @@ Storage::is_data_ready()
 
 	r = 0;
 	if (this->wait_time == 0) {
-		this->current_request = nullptr;
-		this->wait_time = delay;
+		this->release();
 		r = 1;
 	} else {
 		--this->wait_time;
@@ -63,3 +452,41 @@ Storage::is_data_ready()
 
 	return r;
 }
+
+void
+Storage::release()
+{
+	unsigned long latency;
+
+	// prefetches a level makes of itself are not waited on by anyone
+	if (this->current_request != this) {
+		this->ledger.service[0] = this->elapsed;
+		latency = this->ledger.service[0] + this->ledger.contention[0];
+		++this->histogram[std::min(static_cast<int>(std::bit_width(latency)), LATENCY_BUCKETS - 1)];
+		++this->stats[REQUESTS];
+		this->stats[LATENCY_CYCLES] += latency;
+		for (Storage *upper : this->uppers)
+			if (upper == this->current_request)
+				upper->absorb(this->ledger);
+	}
+
+	this->current_request = nullptr;
+	this->wait_time = this->delay;
+	TRACE(COMPLETE, this->request_address);
+}
+
+int
+Storage::invalidate_uppers(int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int r, u;
+
+	r = 0;
+	for (Storage *upper : this->uppers) {
+		u = upper->back_invalidate(address, data_line);
+		if (u)
+			++this->stats[BACK_INVALIDATIONS];
+		r = std::max(r, u);
+	}
+
+	return r;
+}
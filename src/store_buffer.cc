@@ -0,0 +1,196 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "store_buffer.h"
+#include "definitions.h"
+#include <stdexcept>
+
+StoreBuffer::StoreBuffer(Storage *lower, int entries) : Storage(0)
+{
+	if (entries < 1)
+		throw std::invalid_argument("Store buffer must hold at least one line.");
+
+	this->lower = lower;
+	this->entries = entries;
+	this->draining = 0;
+	this->drainer = 0;
+	this->served = 0;
+	this->lower->add_upper(this);
+}
+
+StoreBuffer::~StoreBuffer()
+{
+	if (this->owns_lower)
+		delete this->lower;
+	delete this->data;
+}
+
+int
+StoreBuffer::write_word(void *id, signed int data, int address)
+{
+	std::array<signed int, LINE_SIZE> line = {};
+
+	if (id == nullptr)
+		throw std::invalid_argument("Accessor cannot be nullptr.");
+
+	address = WRAP_ADDRESS(address);
+	line[address % LINE_SIZE] = data;
+	return this->store(address, 1 << (address % LINE_SIZE), line);
+}
+
+int
+StoreBuffer::write_line(void *id, std::array<signed int, LINE_SIZE> data_line, int address)
+{
+	if (id == nullptr)
+		throw std::invalid_argument("Accessor cannot be nullptr.");
+
+	return this->store(WRAP_ADDRESS(address), (1 << LINE_SIZE) - 1, data_line);
+}
+
+int
+StoreBuffer::write_words(
+	void *id, std::array<signed int, LINE_SIZE> data_line, int address, unsigned int mask)
+{
+	if (id == nullptr)
+		throw std::invalid_argument("Accessor cannot be nullptr.");
+
+	return this->store(WRAP_ADDRESS(address), mask, data_line);
+}
+
+int
+StoreBuffer::read_word(void *id, int address, signed int &data)
+{
+	int a;
+
+	address = WRAP_ADDRESS(address);
+	a = address & ~(LINE_SIZE - 1);
+	// the newest store to the word is forwarded
+	for (auto e = this->buffer.rbegin(); e != this->buffer.rend(); ++e)
+		if (e->address == a && (e->mask >> (address % LINE_SIZE) & 1)) {
+			data = e->line[address % LINE_SIZE];
+			++this->stats[STORE_FORWARDS];
+			return 1;
+		}
+
+	return process(id, address, [&](int target, int offset) {
+		(void)offset;
+		this->served = this->lower->read_word(id, target, data);
+	});
+}
+
+int
+StoreBuffer::read_line(void *id, int address, std::array<signed int, LINE_SIZE> &data_line)
+{
+	return this->read_words(id, address, (1 << LINE_SIZE) - 1, data_line);
+}
+
+int
+StoreBuffer::read_words(
+	void *id, int address, unsigned int mask, std::array<signed int, LINE_SIZE> &data_line)
+{
+	int a, i;
+
+	address = WRAP_ADDRESS(address);
+	if (!process(id, address, [&](int target, int offset) {
+			(void)offset;
+			this->served = this->lower->read_words(id, target, mask, data_line);
+		}))
+		return 0;
+
+	// buffered words are newer than those below, oldest first
+	a = address & ~(LINE_SIZE - 1);
+	for (const Entry &e : this->buffer)
+		if (e.address == a)
+			for (i = 0; i < LINE_SIZE; ++i)
+				if ((e.mask & mask) >> i & 1)
+					data_line[i] = e.line[i];
+	return 1;
+}
+
+int
+StoreBuffer::maintain(void *id, enum Maintenance op, int start, int end)
+{
+	return this->buffer.empty() && Storage::maintain(id, op, start, end);
+}
+
+int
+StoreBuffer::fence(void *id)
+{
+	return this->buffer.empty() && Storage::fence(id);
+}
+
+void
+StoreBuffer::tick()
+{
+	Entry *e;
+
+	if (!this->buffer.empty()) {
+		e = &this->buffer.front();
+		this->draining = 1;
+		// every word merged into the entry goes down in one request
+		if (this->lower->write_words(&this->drainer, e->line, e->address, e->mask)) {
+			this->buffer.pop_front();
+			this->draining = 0;
+		}
+	}
+
+	Storage::tick();
+}
+
+int
+StoreBuffer::get_occupancy() const { return this->buffer.size(); }
+
+int
+StoreBuffer::process(void *id, int address, std::function<void(int index, int offset)> request_handler)
+{
+	if (id == nullptr)
+		throw std::invalid_argument("Accessor cannot be nullptr.");
+
+	request_handler(address, 0);
+	if (!this->served)
+		return 0;
+
+	this->served = 0;
+	return 1;
+}
+
+int
+StoreBuffer::store(int address, unsigned int mask, const std::array<signed int, LINE_SIZE> &line)
+{
+	unsigned long i;
+	int a, w;
+
+	a = address & ~(LINE_SIZE - 1);
+	for (i = this->draining; i < this->buffer.size(); ++i)
+		if (this->buffer[i].address == a)
+			break;
+
+	if (i == this->buffer.size()) {
+		if (this->buffer.size() >= static_cast<unsigned long>(this->entries)) {
+			++this->stats[STORE_STALLS];
+			return 0;
+		}
+		this->buffer.push_back({a, 0, {}});
+	} else
+		++this->stats[STORE_MERGES];
+
+	for (w = 0; w < LINE_SIZE; ++w)
+		if (mask >> w & 1)
+			this->buffer[i].line[w] = line[w];
+	this->buffer[i].mask |= mask;
+	return 1;
+}
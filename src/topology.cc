@@ -0,0 +1,91 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "topology.h"
+#include <stdexcept>
+
+Topology::~Topology() { this->clear(); }
+
+Storage *
+Topology::add(const std::string &name, Storage *level)
+{
+	if (this->find(name))
+		throw std::invalid_argument("Level '" + name + "' already exists.");
+
+	level->share_lower();
+	this->levels.push_back({name, level});
+	return level;
+}
+
+Storage *
+Topology::find(const std::string &name) const
+{
+	for (const Level &level : this->levels)
+		if (level.name == name)
+			return level.storage;
+	return nullptr;
+}
+
+const std::vector<Level> &
+Topology::get_levels() const
+{
+	return this->levels;
+}
+
+std::vector<Level>
+Topology::get_tops() const
+{
+	std::vector<Level> r;
+	int built_over;
+
+	for (const Level &level : this->levels) {
+		built_over = 0;
+		for (const Level &other : this->levels)
+			built_over |= other.storage->get_lower() == level.storage;
+		if (!built_over)
+			r.push_back(level);
+	}
+	return r;
+}
+
+void
+Topology::tick()
+{
+	for (Level &level : this->levels)
+		level.storage->tick();
+}
+
+int
+Topology::fence(void *id)
+{
+	int r;
+
+	r = 1;
+	for (Level &level : this->get_tops())
+		r &= level.storage->fence(id);
+	return r;
+}
+
+void
+Topology::clear()
+{
+	// levels above may refer to the levels below them until deleted
+	while (!this->levels.empty()) {
+		delete this->levels.back().storage;
+		this->levels.pop_back();
+	}
+}
@@ -0,0 +1,148 @@
+// Memory subsystem for the RISC-V[ECTOR] mini-ISA
+// Copyright (C) 2025 Siddarth Suresh
+// Copyright (C) 2025 bdunahu
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "tracer.h"
+#include <algorithm>
+#include <climits>
+
+/**
+ * Writes `s' as the contents of a JSON string.
+ * @param the stream to write to
+ * @param the string to escape
+ */
+static void
+write_escaped(std::ostream &out, const std::string &s)
+{
+	for (char ch : s) {
+		if (ch == '"' || ch == '\\')
+			out << '\\' << ch;
+		else if (static_cast<unsigned char>(ch) < 0x20)
+			out << "\\u00" << "0123456789abcdef"[ch >> 4] << "0123456789abcdef"[ch & 0xf];
+		else
+			out << ch;
+	}
+}
+
+Tracer::Tracer(unsigned int capacity_spec)
+{
+	this->capacity_spec = capacity_spec;
+	this->cycle = 0;
+	this->begin = 0;
+	this->end = ULONG_MAX;
+}
+
+Tracer::Ring::Ring(unsigned int capacity_spec)
+{
+	this->buffer.resize(1UL << capacity_spec);
+	this->mask = (1UL << capacity_spec) - 1;
+	this->dropped = 0;
+	this->head = 0;
+	this->tail = 0;
+	this->issued = 0;
+	this->pending = 0;
+}
+
+int
+Tracer::Ring::pop(TraceRecord &r)
+{
+	unsigned long t;
+
+	t = this->tail.load(std::memory_order_relaxed);
+	if (t == this->head.load(std::memory_order_acquire))
+		return 0;
+	r = this->buffer[t & this->mask];
+	this->tail.store(t + 1, std::memory_order_release);
+	return 1;
+}
+
+int
+Tracer::attach(const char *name)
+{
+	this->rings.emplace_back(new Ring(this->capacity_spec));
+	this->names.emplace_back(name);
+	return this->rings.size() - 1;
+}
+
+void
+Tracer::record_request(int level, enum Event event, int address)
+{
+	Ring *r;
+	unsigned long from, to;
+
+	r = this->rings[level].get();
+	if (event == ISSUE) {
+		r->issued = this->cycle;
+		r->pending = 1;
+		return;
+	}
+	if (!r->pending)
+		return;
+	r->pending = 0;
+
+	from = std::max(r->issued, this->begin);
+	to = std::min(this->cycle, this->end);
+	if (r->issued < this->end && this->cycle >= this->begin)
+		r->push_pair({from, address, ISSUE}, {to, address, COMPLETE});
+}
+
+void
+Tracer::tick() { ++this->cycle; }
+
+unsigned long
+Tracer::now() const { return this->cycle; }
+
+void
+Tracer::set_window(unsigned long begin, unsigned long end)
+{
+	this->begin = begin;
+	this->end = end;
+}
+
+unsigned long
+Tracer::get_dropped(int level) const { return this->rings.at(level)->dropped; }
+
+void
+Tracer::write_chrome_trace(std::ostream &out)
+{
+	static const char *names[] = {"issue", "hit", "miss", "evict", "writeback", "complete"};
+	unsigned long i;
+	const char *sep;
+	TraceRecord r;
+
+	sep = "\n";
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	for (i = 0; i < this->rings.size(); ++i) {
+		out << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"";
+		write_escaped(out, this->names[i]);
+		out << "\"}}";
+		sep = ",\n";
+
+		while (this->rings[i]->pop(r)) {
+			out << sep << "{\"name\":\"" << names[r.event] << "\",\"pid\":0,\"tid\":" << i
+				<< ",\"ts\":" << r.cycle << ",";
+			if (r.event == ISSUE)
+				out << "\"ph\":\"B\",";
+			else if (r.event == COMPLETE)
+				out << "\"ph\":\"E\",";
+			else
+				out << "\"ph\":\"i\",\"s\":\"t\",";
+			out << "\"args\":{\"address\":" << r.address << "}}";
+		}
+	}
+	out << "\n]}\n";
+}
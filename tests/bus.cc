@@ -0,0 +1,134 @@
+#include "bus.h"
+#include "cache.h"
+#include "dram.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+class BS
+{
+  public:
+	BS()
+	{
+		std::vector<signed int> memory(256);
+		int i;
+
+		for (i = 0; i < 256; ++i)
+			memory[i] = i;
+		this->d = new Dram(4);
+		this->d->load(memory);
+		this->b = new Bus(this->d, 2, 3);
+	}
+
+	~BS() { delete this->b; }
+
+	/**
+	 * Calls `f' until it reports completion.
+	 * @return the number of cycles taken
+	 */
+	int
+	run_until_done(std::function<int()> f)
+	{
+		int i;
+
+		for (i = 1; !f(); ++i)
+			REQUIRE(i < 1000);
+		return i;
+	}
+
+	Dram *d;
+	Bus *b;
+	int p;
+	int q;
+};
+
+TEST_CASE_METHOD(BS, "data crosses the bus after the lower level responds", "[bus]")
+{
+	std::array<signed int, LINE_SIZE> line;
+	signed int w;
+	int cycles;
+
+	// two bus cycles of three clock cycles each for a line
+	cycles = this->run_until_done([this, &line]() { return this->b->read_line(&this->p, 8, line); });
+	CHECK(cycles == 5 + 6);
+	CHECK(line == std::array<signed int, LINE_SIZE>{8, 9, 10, 11});
+
+	cycles = this->run_until_done([this, &w]() { return this->b->read_word(&this->p, 13, w); });
+	CHECK(cycles == 5 + 3);
+	CHECK(w == 13);
+
+	CHECK(this->b->get_stat(BUS_BUSY_CYCLES) == 19);
+	CHECK(this->b->get_stat(QUEUE_CYCLES) == 0);
+	CHECK(this->b->get_utilization(38) == 0.5);
+	CHECK_THROWS_AS(Bus(nullptr, 0, 1), std::invalid_argument);
+}
+
+TEST_CASE_METHOD(BS, "waiting requesters are granted the bus round-robin", "[bus]")
+{
+	signed int v, w;
+	int i, p_done, q_done;
+
+	// `p' asks first every cycle, but must let `q' go after each of its requests
+	p_done = q_done = 0;
+	for (i = 1; p_done < 2 || q_done < 2; ++i) {
+		REQUIRE(i < 1000);
+		if (p_done < 2 && this->b->read_word(&this->p, p_done, v)) {
+			CHECK(v == p_done);
+			++p_done;
+			CHECK(p_done == q_done + 1);
+		}
+		if (q_done < 2 && this->b->read_word(&this->q, 64 + q_done, w)) {
+			CHECK(w == 64 + q_done);
+			++q_done;
+			CHECK(q_done == p_done);
+		}
+	}
+
+	// four requests of eight cycles each; `q' is granted the bus the cycle `p' releases it, but
+	// `p' asks before `q' releases it
+	CHECK(i - 1 == 4 * 8 - 2);
+	CHECK(this->b->get_stat(BUS_BUSY_CYCLES) == 4 * 8);
+	CHECK(this->b->get_stat(QUEUE_CYCLES) > 0);
+}
+
+TEST_CASE_METHOD(BS, "bursts cross the bus as one request", "[bus]")
+{
+	std::vector<LineWrite> lines;
+	int cycles;
+
+	lines.push_back({0, 0b1111, {-1, -2, -3, -4}});
+	lines.push_back({4, 0b1111, {-5, -6, -7, -8}});
+	lines.push_back({8, 0b0101, {-9, -10, -11, -12}});
+
+	// memory streams the three lines in 5 + 2 cycles, then ten words take five bus cycles
+	cycles =
+		this->run_until_done([this, &lines]() { return this->b->write_lines(&this->p, lines); });
+	CHECK(cycles == 5 + 2 + 15);
+	CHECK(this->b->get_stat(REQUESTS) == 1);
+	CHECK(this->d->get_stat(REQUESTS) == 1);
+	CHECK(this->d->view_line(1) == std::array<signed int, LINE_SIZE>{-5, -6, -7, -8});
+	CHECK(this->d->view_line(2) == std::array<signed int, LINE_SIZE>{-9, 9, -11, 11});
+}
+
+TEST_CASE("fills and writebacks cross the bus", "[bus]")
+{
+	int mem;
+	int i, fast, slow;
+	Cache *c;
+
+	// the same sequence of a fill, then a writeback and a fill, over a narrow and a wide bus
+	for (i = 0; i < 2; ++i) {
+		c = new Cache(new Bus(new Dram(4), i ? 1 : LINE_SIZE, 1), 5, 0, 2);
+		(i ? slow : fast) = 0;
+		while (!c->write_word(&mem, 0x55, 0))
+			++(i ? slow : fast);
+		while (!c->write_word(&mem, 0x66, 128))
+			++(i ? slow : fast);
+		CHECK(c->get_stat(WRITEBACKS) == 1);
+		delete c;
+	}
+
+	// each line crosses three more bus cycles on the narrow bus
+	CHECK(slow - fast == 3 * 3);
+}
@@ -23,7 +23,7 @@ class C11
 		this->fetch = new int();
 		this->c = new Cache(new Dram(this->m_delay), 5, 0, this->c_delay);
 		this->expected = {0, 0, 0, 0};
-		this->actual = this->c->get_data()[0];
+		this->actual = this->c->view_line(0);
 	}
 
 	~C11()
@@ -42,11 +42,26 @@ class C11
 			// check response
 			CHECK(!r);
 			// check for early modifications
-			actual = c->get_data()[0];
+			actual = c->view_line(0);
 			REQUIRE(this->expected == this->actual);
 		}
 	}
 
+	/**
+	 * Calls `f' until it reports completion.
+	 * @param the request to repeat
+	 * @return the number of cycles taken
+	 */
+	int
+	run_until_done(std::function<int()> f)
+	{
+		int i;
+
+		for (i = 1; !f(); ++i)
+			REQUIRE(i < 1000);
+		return i;
+	}
+
 	int m_delay;
 	int c_delay;
 	Cache *c;
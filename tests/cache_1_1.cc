@@ -1,7 +1,9 @@
 #include "c11.h"
 #include "cache.h"
 #include "dram.h"
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
 
 TEST_CASE_METHOD(C11, "store 0th element in DELAY cycles", "[dram]")
 {
@@ -20,7 +22,7 @@ TEST_CASE_METHOD(C11, "store 0th element in DELAY cycles", "[dram]")
 	CHECK(r);
 
 	expected.at(0) = w;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	REQUIRE(expected == actual);
 }
 
@@ -40,7 +42,7 @@ TEST_CASE_METHOD(C11, "store 0th, 1st element in DELAY cycles, with conflict", "
 		CHECK(!r);
 
 		// check for early modifications
-		actual = c->get_data()[0];
+		actual = c->view_line(0);
 		REQUIRE(this->expected == this->actual);
 	}
 
@@ -48,7 +50,7 @@ TEST_CASE_METHOD(C11, "store 0th, 1st element in DELAY cycles, with conflict", "
 	CHECK(r);
 
 	expected.at(0) = w;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	REQUIRE(expected == actual);
 
 	// this should have been loaded already!
@@ -59,7 +61,7 @@ TEST_CASE_METHOD(C11, "store 0th, 1st element in DELAY cycles, with conflict", "
 	CHECK(r);
 
 	expected.at(1) = w;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	REQUIRE(expected == actual);
 }
 
@@ -81,7 +83,7 @@ TEST_CASE_METHOD(
 	CHECK(r);
 
 	expected.at(0) = w;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	REQUIRE(expected == actual);
 
 	// write back to memory
@@ -95,7 +97,7 @@ TEST_CASE_METHOD(
 	CHECK(r);
 
 	expected.at(0) = 0;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	CHECK(expected == actual);
 
 	this->wait_then_do(
@@ -106,6 +108,375 @@ TEST_CASE_METHOD(
 
 	expected.at(0) = 0;
 	expected.at(1) = w;
-	actual = c->get_data()[0];
+	actual = c->view_line(0);
 	REQUIRE(expected == actual);
 }
+
+TEST_CASE_METHOD(C11, "critical word first forwards the missed word early", "[cache]")
+{
+	int cycles;
+	signed int w;
+
+	this->c->set_critical_word_first(1);
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1, w); });
+	CHECK(cycles == this->m_delay + 1);
+	CHECK(this->c->get_stat(EARLY_RESTARTS) == 1);
+
+	// the critical word was 1, so word 0 arrives last
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b0, w); });
+	CHECK(cycles == this->c_delay + 3);
+	CHECK(this->c->get_stat(STREAM_STALLS) == 2);
+
+	// the whole line has arrived
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10, w); });
+	CHECK(cycles == this->c_delay + 1);
+
+	CHECK(this->c->get_stat(LOADS) == 3);
+	CHECK(this->c->get_stat(LOAD_CYCLES) == (unsigned long)(this->m_delay + 2 * this->c_delay + 5));
+}
+
+TEST_CASE_METHOD(C11, "compressed lines share a set", "[cache]")
+{
+	int i, cycles;
+	signed int w;
+	Dram *d;
+	std::vector<signed int> memory(1024, 0);
+
+	// 0b1000000000 holds a base-delta line, 0b1010000000 an uncompressible one
+	memory[512] = 1000;
+	memory[513] = 1001;
+	memory[514] = 1002;
+	memory[515] = 1003;
+	memory[640] = 1;
+	memory[641] = 100000;
+	memory[642] = -7;
+	memory[643] = 123456789;
+	d = new Dram(this->m_delay);
+	d->load(memory);
+	delete this->c;
+	this->c = new Cache(d, 5, 0, this->c_delay);
+	this->c->set_compression(2, 1);
+
+	// four zero lines fit in the space of one
+	for (i = 0; i < 4; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 7, w); });
+	for (i = 0; i < 4; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 7, w); });
+	CHECK(this->c->get_stat(MISSES) == 4);
+	CHECK(this->c->get_stat(HITS) == 4);
+	CHECK(this->c->get_compression_ratio() == 16.0);
+
+	// base-delta lines take longer to read out
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 514, w); });
+	CHECK(w == 1002);
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 515, w); });
+	CHECK(w == 1003);
+	CHECK(cycles == this->c_delay + 2);
+	CHECK(this->c->get_stat(DECOMPRESSION_CYCLES) == 1);
+	CHECK(this->c->get_stat(EVICTIONS) == 1);
+
+	// an uncompressible line needs the whole set
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 641, w); });
+	CHECK(w == 100000);
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 642, w); });
+	CHECK(w == -7);
+	CHECK(this->c->get_stat(EVICTIONS) == 5);
+	CHECK(this->c->get_compression_ratio() == 1.0);
+	CHECK(this->c->get_stat(UNCOMPRESSED_BYTES) == 6 * 16);
+	CHECK(this->c->get_stat(COMPRESSED_BYTES) == 4 + 8 + 16);
+}
+
+TEST_CASE_METHOD(C11, "predicted ways hit faster than mispredicted ways", "[cache]")
+{
+	int cycles;
+	signed int w;
+
+	delete this->c;
+	this->c = new Cache(new Dram(this->m_delay), 5, 1, this->c_delay);
+	this->c->set_way_prediction(0, 1);
+
+	// 0b0 and 0b1000000 share a set, and are filled into different ways
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b0, w); });
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1000000, w); });
+	CHECK(this->c->view_meta(0).at(0) == 0);
+	CHECK(this->c->view_meta(1).at(0) == 1);
+
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b0, w); });
+	CHECK(cycles == this->c_delay + 2);
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1, w); });
+	CHECK(cycles == 1);
+
+	CHECK(this->c->get_stat(PREDICTED_WAYS) == 1);
+	CHECK(this->c->get_stat(MISPREDICTED_WAYS) == 1);
+	CHECK(this->c->get_stat(HITS) == 2);
+}
+
+TEST_CASE_METHOD(C11, "partitions fill only their own ways", "[cache]")
+{
+	int other, i;
+	signed int w;
+
+	delete this->c;
+	this->c = new Cache(new Dram(this->m_delay), 5, 2, this->c_delay);
+	this->c->set_partition(&other, 1);
+	this->c->set_way_mask(0, 0b0011);
+	this->c->set_way_mask(1, 0b1100);
+	CHECK_THROWS_AS(this->c->set_way_mask(1, 0b10000), std::invalid_argument);
+	CHECK_THROWS_AS(this->c->get_way_mask(2), std::out_of_range);
+
+	// `mem' keeps two lines of set 0, while `other' streams through it
+	for (i = 0; i < 2; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 5, w); });
+	for (i = 2; i < 10; ++i)
+		this->run_until_done([this, &w, i, &other]() { return this->c->read_word(&other, i << 5, w); });
+	for (i = 0; i < 2; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 5, w); });
+
+	CHECK(this->c->get_partition_stat(0, HITS) == 2);
+	CHECK(this->c->get_partition_stat(0, MISSES) == 2);
+	CHECK(this->c->get_partition_stat(1, MISSES) == 8);
+	CHECK(this->c->get_occupancy(0) == 2);
+	CHECK(this->c->get_occupancy(1) == 2);
+	CHECK(this->c->get_stat(EVICTIONS) == 6);
+}
+
+TEST_CASE_METHOD(C11, "partition caches wider than a way mask", "[cache]")
+{
+	int other, i;
+	signed int w;
+	std::vector<bool> ways(128, false);
+
+	// 64 ways still fit a mask
+	delete this->c;
+	this->c = new Cache(new Dram(this->m_delay), 6, 6, this->c_delay);
+	this->c->set_partition(&other, 1);
+	CHECK(this->c->get_way_mask(1) == ~0UL);
+	this->c->set_way_mask(1, 1UL << 63);
+	for (i = 0; i < 4; ++i)
+		this->run_until_done([this, &w, i, &other]() { return this->c->read_word(&other, i << 2, w); });
+	CHECK(this->c->get_occupancy(1) == 1);
+	CHECK(this->c->view_meta(63).at(0) == 3);
+
+	// `mem' keeps the first 64 ways of a fully associative cache, while `other' streams through
+	delete this->c;
+	this->c = new Cache(new Dram(this->m_delay), 7, 7, this->c_delay);
+	this->c->set_partition(&other, 1);
+	CHECK_THROWS_AS(this->c->get_way_mask(1), std::out_of_range);
+	CHECK_THROWS_AS(this->c->set_way_mask(1, ways), std::invalid_argument);
+	std::fill(ways.begin() + 64, ways.end(), true);
+	this->c->set_way_mask(1, ways);
+	std::fill(ways.begin(), ways.end(), false);
+	std::fill(ways.begin(), ways.begin() + 64, true);
+	this->c->set_way_mask(0, ways);
+	CHECK(this->c->get_ways(0) == ways);
+
+	for (i = 0; i < 64; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 2, w); });
+	for (i = 64; i < 256; ++i)
+		this->run_until_done([this, &w, i, &other]() { return this->c->read_word(&other, i << 2, w); });
+	for (i = 0; i < 64; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 2, w); });
+	CHECK(this->c->get_partition_stat(0, HITS) == 64);
+	CHECK(this->c->get_occupancy(1) == 64);
+
+	// repartitioning divides the ways without overflowing a mask
+	this->c->set_dynamic_partitioning(16);
+	for (i = 0; i < 64; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 2, w); });
+	CHECK(std::count(this->c->get_ways(0).begin(), this->c->get_ways(0).end(), true) +
+			  std::count(this->c->get_ways(1).begin(), this->c->get_ways(1).end(), true) ==
+		  128);
+}
+
+TEST_CASE_METHOD(C11, "utility-based partitioning gives ways to the partition which reuses them", "[cache]")
+{
+	int other, i, j;
+	signed int w;
+
+	delete this->c;
+	this->c = new Cache(new Dram(this->m_delay), 5, 2, this->c_delay);
+	this->c->set_partition(&other, 1);
+	this->c->set_dynamic_partitioning(40);
+	CHECK(this->c->get_way_mask(0) == 0b1111);
+
+	// `mem' reuses three lines of set 0, while `other' never reuses a line
+	for (j = 0; j < 5; ++j)
+		for (i = 0; i < 4; ++i) {
+			this->run_until_done([this, &w, i]() {
+				return this->c->read_word(this->mem, (i % 3) << 5, w);
+			});
+			this->run_until_done([this, &w, i, j, &other]() {
+				return this->c->read_word(&other, (4 * j + i + 3) << 5, w);
+			});
+		}
+
+	CHECK(this->c->get_way_mask(0) == 0b0111);
+	CHECK(this->c->get_way_mask(1) == 0b1000);
+}
+
+TEST_CASE_METHOD(C11, "classify misses as compulsory, capacity or conflict", "[cache]")
+{
+	signed int w;
+	int i;
+
+	this->c->set_miss_classification(1);
+	// 0b0 and 0b10000000 share a line's place in a direct-mapped cache
+	for (int a : {0b0, 0b10000000, 0b0})
+		this->run_until_done([this, &w, a]() { return this->c->read_word(this->mem, a, w); });
+	CHECK(this->c->get_stat(COMPULSORY_MISSES) == 2);
+	CHECK(this->c->get_stat(CONFLICT_MISSES) == 1);
+
+	// more lines than the cache holds
+	for (i = 100; i < 140; ++i)
+		this->run_until_done([this, &w, i]() { return this->c->read_word(this->mem, i << 2, w); });
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1, w); });
+	CHECK(this->c->get_stat(COMPULSORY_MISSES) == 42);
+	CHECK(this->c->get_stat(CAPACITY_MISSES) == 1);
+	CHECK(this->c->get_stat(CONFLICT_MISSES) == 1);
+	CHECK(this->c->get_stat(MISSES) == 44);
+}
+
+TEST_CASE_METHOD(C11, "sectored lines fetch and write back only the words needed", "[cache]")
+{
+	signed int w;
+
+	CHECK_THROWS_AS(this->c->set_sectors(LINE_SPEC + 1, 0), std::invalid_argument);
+	this->c->set_sectors(LINE_SPEC, 1);
+	CHECK_THROWS_AS(this->c->set_inclusion(EXCLUSIVE), std::invalid_argument);
+
+	// one word sectors, each miss fetches the next word with it
+	this->run_until_done([this]() { return this->c->write_word(this->mem, 0x11, 0b1); });
+	CHECK(this->c->get_valid_words(0) == 0b0110);
+	CHECK(this->c->get_dirty_words(0) == 0b0010);
+	CHECK(this->c->get_stat(FILL_WORDS_SAVED) == 2);
+
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b0, w); });
+	CHECK(this->c->get_valid_words(0) == 0b0111);
+	CHECK(this->c->get_stat(SECTOR_MISSES) == 1);
+	CHECK(this->c->get_stat(MISSES) == 2);
+	CHECK(this->c->get_stat(FILL_WORDS_SAVED) == 5);
+
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10, w); });
+	CHECK(this->c->get_stat(HITS) == 1);
+
+	// only the dirty word is written back
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10000000, w); });
+	CHECK(this->c->get_stat(WRITEBACKS) == 1);
+	CHECK(this->c->get_stat(WRITEBACK_WORDS_SAVED) == 3);
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1, w); });
+	CHECK(w == 0x11);
+	CHECK(this->c->get_dirty_words(0) == 0);
+}
+
+TEST_CASE_METHOD(C11, "hashed indexing spreads power-of-two strides across sets", "[cache]")
+{
+	signed int w;
+	int i;
+
+	// lines 0, 32, 64 and 96 all map to set 0 by their low bits
+	for (enum Indexing f : {MODULO, XOR_FOLD, PRIME_MODULO}) {
+		Cache c(new Dram(this->m_delay), 5, 0, this->c_delay);
+		c.set_indexing(f);
+		for (i = 0; i < 8; ++i)
+			this->run_until_done([&c, &w, i]() { return c.read_word(&c, (i % 4) << 7, w); });
+		CHECK(c.get_stat(MISSES) == (f == MODULO ? 8 : 4));
+	}
+
+	// each way of a skewed cache places lines 0, 16, 32 and 48 in a different set
+	for (enum Indexing f : {MODULO, SKEWED}) {
+		Cache c(new Dram(this->m_delay), 5, 1, this->c_delay);
+		c.set_indexing(f);
+		for (i = 0; i < 8; ++i)
+			this->run_until_done([&c, &w, i]() { return c.read_word(&c, (i % 4) << 6, w); });
+		CHECK(c.get_stat(MISSES) == (f == MODULO ? 8 : 4));
+	}
+	Cache skewed(new Dram(this->m_delay), 5, 1, this->c_delay);
+	skewed.set_indexing(SKEWED);
+	CHECK_THROWS_AS(skewed.set_way_prediction(1, 1), std::invalid_argument);
+
+	// evicted lines are written back to the address they came from
+	this->c->set_indexing(XOR_FOLD);
+	this->run_until_done([this]() { return this->c->write_word(this->mem, 0x11, 0b1); });
+	// line 33 folds to set 0
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 33 << 2, w); });
+	CHECK(this->c->get_stat(WRITEBACKS) == 1);
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1, w); });
+	CHECK(w == 0x11);
+}
+
+TEST_CASE_METHOD(C11, "fully associative caches replace the least recently used line", "[cache]")
+{
+	int i;
+	signed int w;
+	Cache c(new Dram(this->m_delay), 10, 10, this->c_delay);
+
+	for (i = 0; i < 1024; ++i)
+		this->run_until_done([&c, &w, i]() { return c.read_word(&c, i << 2, w); });
+	// line 0 is used again, so line 1 is replaced, then line 0 still hits
+	this->run_until_done([&c, &w]() { return c.read_word(&c, 0, w); });
+	this->run_until_done([&c, &w]() { return c.read_word(&c, 1024 << 2, w); });
+	this->run_until_done([&c, &w]() { return c.read_word(&c, 0, w); });
+	CHECK(c.get_stat(MISSES) == 1025);
+	CHECK(c.view_meta(1).at(0) == 1024);
+	this->run_until_done([&c, &w]() { return c.read_word(&c, 1 << 2, w); });
+	CHECK(c.get_stat(MISSES) == 1026);
+	CHECK(c.view_meta(2).at(0) == 1);
+
+	// invalidated lines are refilled before any line in use is replaced
+	this->run_until_done([&c]() { return c.maintain(&c, INVALIDATE, 100 << 2, 102 << 2); });
+	this->run_until_done([&c, &w]() { return c.read_word(&c, 2000 << 2, w); });
+	CHECK(c.view_meta(100).at(0) == 2000);
+	CHECK(c.view_meta(3).at(0) == 3);
+}
+
+TEST_CASE_METHOD(C11, "flushed lines are written back as one burst", "[cache]")
+{
+	int i, cycles;
+	Storage *d;
+
+	for (i = 0; i < 8; ++i)
+		this->run_until_done([this, i]() { return this->c->write_word(this->mem, i + 1, i << 2); });
+	d = this->c->get_lower();
+	CHECK(d->get_stat(REQUESTS) == 8);
+
+	cycles = this->run_until_done([this]() { return this->c->flush(this->mem); });
+	// the first line takes the full latency, and each after it one cycle
+	CHECK(cycles < 8 * (this->m_delay + 1));
+	CHECK(this->c->get_stat(WRITEBACKS) == 8);
+	CHECK(d->get_stat(REQUESTS) == 9);
+	for (i = 0; i < 8; ++i) {
+		CHECK(d->view_line(i).at(0) == i + 1);
+		CHECK(this->c->view_meta(i).at(0) == -1);
+	}
+}
+
+TEST_CASE_METHOD(C11, "inspect held and dirty lines without copying", "[cache]")
+{
+	int count;
+	signed int w;
+	LineView view = this->c->view_lines(0, 4);
+
+	this->run_until_done([this]() { return this->c->write_word(this->mem, 0x11, 0b10000100); });
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1000, w); });
+
+	CHECK(view.size() == 4);
+	CHECK(view[1].at(0) == 0x11);
+	CHECK(&view[1] == &this->c->view_line(1));
+	CHECK(this->c->view_meta(1).at(0) == 1);
+	CHECK(this->c->view_meta(1).at(1) == 1);
+	CHECK(this->c->view_meta(2).at(1) == -1);
+
+	count = 0;
+	for (CacheLine line : this->c->lines(VALID_LINES))
+		count += line.index;
+	CHECK(count == 3);
+
+	count = 0;
+	for (CacheLine line : this->c->lines(DIRTY_LINES)) {
+		CHECK(line.address == 0b10000100);
+		CHECK(line.data->at(0) == 0x11);
+		++count;
+	}
+	CHECK(count == 1);
+	CHECK_THROWS_AS(this->c->view_lines(30, 4), std::out_of_range);
+}
@@ -43,12 +43,12 @@ TEST_CASE_METHOD(C21, "store 32th, 96th element in DELAY cycles, evict to level
 
 	// check level 2
 	// note this is write-back == no write
-	actual = this->c2->get_data()[32];
+	actual = this->c2->view_line(32);
 	REQUIRE(expected == actual);
 
 	// check level 1
 	expected.at(0) = w;
-	actual = this->c->get_data()[0];
+	actual = this->c->view_line(0);
 	REQUIRE(expected == actual);
 
 	// wait = evict
@@ -57,7 +57,7 @@ TEST_CASE_METHOD(C21, "store 32th, 96th element in DELAY cycles, evict to level
 	});
 
 	// check level 2
-	actual = this->c2->get_data()[32];
+	actual = this->c2->view_line(32);
 	REQUIRE(expected == actual);
 
 	// read in line
@@ -75,13 +75,299 @@ TEST_CASE_METHOD(C21, "store 32th, 96th element in DELAY cycles, evict to level
 	CHECK(r);
 
 	// check level 2
-	actual = this->c2->get_data()[96];
+	actual = this->c2->view_line(96);
 	REQUIRE(expected == actual);
 	expected.at(0) = w;
-	actual = this->c2->get_data()[32];
+	actual = this->c2->view_line(32);
 	REQUIRE(expected == actual);
 
 	// check level 1
-	actual = this->c->get_data()[0];
+	actual = this->c->view_line(0);
 	REQUIRE(expected == actual);
 }
+
+/**
+ * Two way associative level 1 over a one way associative level 2, so that level 2 can evict a line
+ * still held by level 1.
+ * LEVEL1: OFFSET=2, INDEX=4(16), TAG=8
+ * LEVEL2: OFFSET=2, INDEX=7(128), TAG=5
+ */
+class C22 : public C21
+{
+  public:
+	C22() : C21()
+	{
+		delete this->c;
+		this->d = new Dram(this->m_delay);
+		this->c2 = new Cache(this->d, 7, 0, this->c_delay);
+		this->c = new Cache(this->c2, 5, 1, this->c_delay);
+	}
+
+	Dram *d;
+};
+
+TEST_CASE_METHOD(C22, "non-inclusive level 2 keeps dirty level 1 lines on eviction", "[2level_cache]")
+{
+	signed int w;
+
+	w = 0x11223344;
+	this->run_until_done([this, w]() { return this->c->write_word(this->mem, w, 0b10000000); });
+	this->run_until_done([this, w]() { return this->c->write_word(this->mem, w, 0b1010000000); });
+
+	// level 1 still holds 0b10000000, so memory is stale
+	CHECK(this->c2->get_stat(BACK_INVALIDATIONS) == 0);
+	actual = this->d->view_line(32);
+	REQUIRE(expected == actual);
+}
+
+TEST_CASE_METHOD(C22, "inclusive level 2 back-invalidates level 1 on eviction", "[2level_cache]")
+{
+	signed int w;
+
+	this->c2->set_inclusion(INCLUSIVE);
+	w = 0x11223344;
+	this->run_until_done([this, w]() { return this->c->write_word(this->mem, w, 0b10000000); });
+	this->run_until_done([this, w]() { return this->c->write_word(this->mem, w, 0b1010000000); });
+
+	// the dirty level 1 copy was merged into the eviction
+	CHECK(this->c2->get_stat(BACK_INVALIDATIONS) == 1);
+	CHECK(this->c2->get_stat(WRITEBACKS) == 1);
+	expected.at(0) = w;
+	actual = this->d->view_line(32);
+	REQUIRE(expected == actual);
+
+	// the line must be fetched again
+	w = 0;
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10000000, w); });
+	CHECK(w == 0x11223344);
+	CHECK(this->c->get_stat(MISSES) == 3);
+}
+
+TEST_CASE_METHOD(C21, "exclusive level 2 swaps lines with level 1", "[2level_cache]")
+{
+	signed int w;
+	Dram *d;
+
+	delete this->c;
+	d = new Dram(this->m_delay);
+	d->load(std::vector<signed int>(512, 0x11223344));
+	this->c2 = new Cache(d, 7, 0, this->c_delay);
+	this->c2->set_inclusion(EXCLUSIVE);
+	this->c = new Cache(this->c2, 5, 0, this->c_delay);
+
+	// misses bypass level 2
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10000000, w); });
+	CHECK(w == 0x11223344);
+	actual = this->c2->view_line(32);
+	REQUIRE(expected == actual);
+
+	// clean victims are swapped into level 2 as they are, without a fill from memory
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b100000000, w); });
+	expected = {w, w, w, w};
+	actual = this->c2->view_line(32);
+	REQUIRE(expected == actual);
+	CHECK(d->get_stat(REQUESTS) == 2);
+	CHECK(!(this->c2->lines(DIRTY_LINES).begin() != this->c2->lines(DIRTY_LINES).end()));
+
+	// hits are handed back to level 1
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b10000000, w); });
+	CHECK(this->c2->get_stat(HITS) == 1);
+	actual = this->c2->view_line(64);
+	REQUIRE(expected == actual);
+}
+
+TEST_CASE_METHOD(C22, "clean, invalidate and flush ranges through both levels", "[2level_cache]")
+{
+	int i;
+	signed int w;
+
+	w = 0x11223344;
+	for (i = 0; i < 4; ++i)
+		this->run_until_done([this, w, i]() { return this->c->write_word(this->mem, w + i, i << 4); });
+
+	// clean one line through both levels
+	this->run_until_done([this]() { return this->c->clean(this->mem, 16, 20); });
+	CHECK(this->d->view_line(4).at(0) == w + 1);
+	CHECK(this->d->view_line(8).at(0) == 0);
+	i = 0;
+	for (CacheLine line : this->c->lines(DIRTY_LINES)) {
+		CHECK(line.address != 16);
+		++i;
+	}
+	CHECK(i == 3);
+
+	// dropped lines are read again from level 2
+	this->run_until_done([this]() { return this->c->invalidate(this->mem, 32, 36); });
+	CHECK(this->c->get_stat(WRITEBACKS) == 1);
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 32, w); });
+	CHECK(w == 0);
+
+	// the remaining dirty line in level 1 is written back in the same pass as level 2's
+	w = 0x11223344;
+	this->run_until_done([this]() { return this->c->flush(this->mem); });
+	CHECK(this->d->view_line(0).at(0) == w);
+	CHECK(this->d->view_line(12).at(0) == w + 3);
+	CHECK(this->c->get_stat(WRITEBACKS) == 3);
+	CHECK(this->c2->get_stat(WRITEBACKS) == 3);
+	CHECK(this->c->get_stat(MAINTENANCE_CYCLES) > 0);
+	for (i = 0; i < 32; ++i)
+		REQUIRE(this->c->view_meta(i).at(0) == -1);
+
+	CHECK(this->c->fence(this->mem));
+}
+
+TEST_CASE_METHOD(C22, "level 1 caches flush into a shared level 2 together", "[2level_cache]")
+{
+	Cache other(this->c2, 5, 1, this->c_delay);
+	int i, done, other_done;
+
+	other.share_lower();
+	for (i = 0; i < 3; ++i) {
+		this->run_until_done([this, i]() { return this->c->write_word(this->mem, i + 1, i << 2); });
+		this->run_until_done(
+			[this, i, &other]() { return other.write_word(this->fetch, i + 11, 64 + (i << 2)); });
+	}
+
+	// level 2 alternates between the two bursts, and each resumes where it left off
+	this->c2->set_arbitration(ROUND_ROBIN, 0);
+	done = other_done = 0;
+	for (i = 0; !done || !other_done; ++i) {
+		REQUIRE(i < 1000);
+		done = done || this->c->flush(this->mem);
+		other_done = other_done || other.flush(this->fetch);
+	}
+	for (i = 0; i < 3; ++i) {
+		CHECK(this->d->view_line(i).at(0) == i + 1);
+		CHECK(this->d->view_line(16 + i).at(0) == i + 11);
+	}
+}
+
+TEST_CASE_METHOD(C22, "level 1 writes back to level 2 as one burst", "[2level_cache]")
+{
+	unsigned long requests;
+	int i;
+
+	for (i = 0; i < 8; ++i)
+		this->run_until_done([this, i]() { return this->c->write_word(this->mem, i, i << 2); });
+	requests = this->c2->get_stat(REQUESTS);
+
+	// the burst is one request at level 2, after which level 2 cleans its own lines
+	this->run_until_done([this]() { return this->c->clean(this->mem, 0, 32); });
+	CHECK(this->c2->get_stat(REQUESTS) == requests + 2);
+	CHECK(this->c2->get_stat(HITS) == 8);
+	CHECK(this->c->get_stat(WRITEBACKS) == 8);
+	CHECK(this->c2->get_stat(WRITEBACKS) == 8);
+	for (i = 0; i < 8; ++i)
+		CHECK(this->d->view_line(i).at(0) == i);
+}
+
+TEST_CASE_METHOD(C21, "fence waits for requests in flight below", "[2level_cache]")
+{
+	int other;
+	signed int w;
+
+	this->c2->read_word(&other, 0, w);
+	CHECK(!this->c->fence(this->mem));
+	this->run_until_done([this, &other, &w]() { return this->c2->read_word(&other, 0, w); });
+	CHECK(this->c->fence(this->mem));
+}
+
+TEST_CASE_METHOD(C22, "prefetches fill the chosen level in the background", "[2level_cache]")
+{
+	signed int w;
+	int i;
+
+	// into level 2, then used by a level 1 miss
+	CHECK(this->c->prefetch(this->mem, 0b100, 1));
+	this->run_until_done([this]() {
+		this->c->tick();
+		return this->c2->get_stat(PREFETCHES) == 1;
+	});
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b100, w); });
+	CHECK(this->c2->get_stat(HITS) == 1);
+	CHECK(this->c2->get_stat(USEFUL_PREFETCHES) == 1);
+
+	// into level 1, where the access then hits
+	CHECK(this->c->prefetch(this->mem, 0b1000, 0));
+	this->run_until_done([this]() {
+		this->c->tick();
+		return this->c->get_stat(PREFETCHES) == 1;
+	});
+	CHECK(this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b1000, w); }) ==
+		  this->c_delay + 1);
+	CHECK(this->c->get_stat(USEFUL_PREFETCHES) == 1);
+
+	// evicted before it was used
+	CHECK(this->c->prefetch(this->mem, 0b1100, 0));
+	this->run_until_done([this]() {
+		this->c->tick();
+		return this->c->get_stat(PREFETCHES) == 2;
+	});
+	for (int a : {76, 140})
+		this->run_until_done([this, &w, a]() { return this->c->read_word(this->mem, a, w); });
+	CHECK(this->c->get_stat(USELESS_PREFETCHES) == 1);
+
+	// the queue is bounded, and held lines are dropped
+	for (i = 0; i < PREFETCH_QUEUE_SIZE; ++i)
+		CHECK(this->c->prefetch(this->mem, 0b1000000000 + (i << 2), 0));
+	CHECK(!this->c->prefetch(this->mem, 0b1000000000 + (i << 2), 0));
+	CHECK(this->c->prefetch(this->mem, 0b1000000000, 0));
+}
+
+TEST_CASE_METHOD(C22, "non-temporal accesses bypass or insert at the LRU position", "[2level_cache]")
+{
+	signed int w;
+
+	this->run_until_done(
+		[this]() { return this->c->write_word_non_temporal(this->mem, 0x11, 0b10000); });
+	CHECK(this->c->get_stat(BYPASSES) == 1);
+	CHECK(this->c2->get_stat(BYPASSES) == 1);
+	CHECK(this->d->view_line(4).at(0) == 0x11);
+
+	// lines 5, 21 and 37 share a set of level 1
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 20, w); });
+	this->run_until_done(
+		[this, &w]() { return this->c->read_word_non_temporal(this->mem, 84, w); });
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 148, w); });
+	this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 20, w); });
+	CHECK(this->c->get_stat(HITS) == 1);
+	CHECK(this->c->get_stat(MISSES) == 4);
+
+	// level 2 also filled line 21 at the LRU position
+	CHECK(this->c2->view_meta(21).at(2) == -1);
+	CHECK(this->c2->view_meta(37).at(2) >= 0);
+}
+
+TEST_CASE_METHOD(C22, "ledgers attribute request latency to each level", "[2level_cache]")
+{
+	signed int w;
+	int cycles, mem_done, fetch_done;
+	unsigned long total;
+
+	cycles = this->run_until_done([this, &w]() { return this->c->read_word(this->mem, 0b0, w); });
+	const Ledger &ledger = this->c->get_ledger();
+	CHECK(ledger.hit_level == 2);
+	REQUIRE(ledger.service.size() == 3);
+	CHECK(ledger.service[0] == static_cast<unsigned long>(cycles));
+	CHECK(ledger.service[1] == this->c2->get_ledger().service[0]);
+	CHECK(ledger.service[2] == this->d->get_ledger().service[0]);
+	CHECK(ledger.service[2] == static_cast<unsigned long>(this->m_delay + 1));
+	CHECK(this->c->get_stat(LOWER_CYCLES) == ledger.service[1]);
+
+	// `fetch' is refused until `mem' hits, then is granted the same cycle
+	mem_done = fetch_done = 0;
+	while (!fetch_done) {
+		mem_done = mem_done || this->c->read_word(this->mem, 0b0, w);
+		fetch_done = this->c->read_word(this->fetch, 0b1, w);
+	}
+	CHECK(this->c->get_ledger().hit_level == 0);
+	CHECK(this->c->get_ledger().contention[0] == static_cast<unsigned long>(this->c_delay));
+	CHECK(this->c->get_stat(REQUESTS) == 3);
+
+	total = 0;
+	for (unsigned long n : this->c->get_latency_histogram())
+		total += n;
+	CHECK(total == 3);
+	CHECK(this->c->get_latency_percentile(0.5) == 7);
+	CHECK(this->c->get_latency_percentile(1.0) >= static_cast<unsigned long>(cycles));
+}
@@ -0,0 +1,116 @@
+#include "bus.h"
+#include "cache.h"
+#include "config.h"
+#include "dram.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <stdexcept>
+
+TEST_CASE("build a hierarchy from a config", "[config]")
+{
+	std::istringstream config("# two levels over a bus\n"
+							  "dram delay=4\n"
+							  "\n"
+							  "bus width=2 ratio=0x1\n"
+							  "cache size=7 delay=2 inclusion=inclusive arbitration=oldest queue=2\n"
+							  "cache name=l1 size=5 ways=1 delay=1 predict=0,1 classify=1  # top\n");
+	Topology topology;
+	Storage *top;
+	Cache *l1;
+	signed int w;
+	int id, i;
+
+	top = build_hierarchy(config, topology);
+	const std::vector<Level> &levels = topology.get_levels();
+	REQUIRE(levels.size() == 4);
+	CHECK(levels[0].name == "dram0");
+	CHECK(levels[1].name == "bus1");
+	CHECK(levels[2].name == "cache2");
+	CHECK(levels[3].name == "l1");
+	CHECK(levels[3].storage == top);
+	CHECK(dynamic_cast<Dram *>(levels[0].storage));
+	CHECK(dynamic_cast<Bus *>(levels[1].storage));
+	CHECK(levels[2].storage->get_inclusion() == INCLUSIVE);
+	l1 = dynamic_cast<Cache *>(top);
+	REQUIRE(l1);
+	CHECK(l1->get_size() == 5);
+
+	for (i = 0; i < 2; ++i)
+		while (!top->read_word(&id, 0, w))
+			;
+	CHECK(l1->get_stat(PREDICTED_WAYS) == 1);
+	CHECK(l1->get_stat(COMPULSORY_MISSES) == 1);
+	CHECK(levels[2].storage->get_stat(MISSES) == 1);
+	CHECK(levels[1].storage->get_stat(BUS_BUSY_CYCLES) > 0);
+}
+
+TEST_CASE("build split instruction and data caches over a shared level", "[config]")
+{
+	std::istringstream config("dram delay=4\n"
+							  "cache name=l2 size=7 delay=2\n"
+							  "icache name=l1i size=5 ways=1 delay=1\n"
+							  "cache name=l1d lower=l2 size=5 ways=1 delay=1\n");
+	Topology topology;
+	Storage *top;
+	std::vector<Level> tops;
+
+	top = build_hierarchy(config, topology);
+	CHECK(top == topology.find("l1d"));
+	CHECK(topology.find("l1i")->get_lower() == topology.find("l2"));
+	CHECK(top->get_lower() == topology.find("l2"));
+	tops = topology.get_tops();
+	REQUIRE(tops.size() == 2);
+	CHECK(tops[0].name == "l1i");
+	CHECK(tops[1].name == "l1d");
+}
+
+TEST_CASE("build routers in front of a shared scratchpad", "[config]")
+{
+	std::istringstream config("dram name=mem delay=4\n"
+							  "scratchpad name=spm base=0x3000 lines=64 delay=1\n"
+							  "router name=fill scratchpad=spm\n"
+							  "cache name=l1 lower=mem size=5 delay=1\n"
+							  "router name=core scratchpad=spm\n");
+	Topology topology;
+	Storage *top;
+
+	top = build_hierarchy(config, topology);
+	CHECK(top == topology.find("core"));
+	CHECK(top->get_lower() == topology.find("l1"));
+	CHECK(topology.find("fill")->get_lower() == topology.find("mem"));
+	CHECK(topology.find("spm")->get_lower() == nullptr);
+}
+
+TEST_CASE("reject malformed configs", "[config]")
+{
+	std::vector<std::string> bad = {
+		"",
+		"cache size=5 delay=1\n",
+		"dram delay=4\ndram delay=4\n",
+		"dram\n",
+		"dram delay=4 speed=2\n",
+		"dram delay=four\n",
+		"dram delay=4\ncache size=5 delay=1 inclusion=sometimes\n",
+		"dram delay=4\ncache size=5 delay=1 predict=1\n",
+		"dram delay=4\ncache size=5 ways=6 delay=1\n",
+		"dram delay=4\nbus width=0\n",
+		"dram delay=4 arbitration=lottery\n",
+		"dram delay=4 queue=2\n",
+		"dram delay=4\ntape delay=100\n",
+		"dram delay=4\nstorebuffer\n",
+		"dram delay=4\ncache size=5 delay\n",
+		"dram delay=4\ncache size=5 delay=1 lower=l3\n",
+		"dram delay=4 lower=dram0\n",
+		"dram name=l1 delay=4\ncache name=l1 size=5 delay=1\n",
+		"dram delay=4\nscratchpad base=0x3002 lines=4 delay=1\n",
+		"dram delay=4\nscratchpad base=0x3ff0 lines=8 delay=1\n",
+		"dram delay=4\nscratchpad base=0 lines=4 delay=1 lower=dram0\n",
+		"dram delay=4\nrouter scratchpad=dram0\n"};
+	Topology topology;
+
+	for (const std::string &s : bad) {
+		std::istringstream config(s);
+		CHECK_THROWS_AS(build_hierarchy(config, topology), std::invalid_argument);
+		CHECK(topology.get_levels().empty());
+	}
+}
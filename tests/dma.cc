@@ -0,0 +1,131 @@
+#include "cache.h"
+#include "dma.h"
+#include "dram.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+class DM
+{
+  public:
+	DM()
+	{
+		std::vector<signed int> memory(256);
+		int i;
+
+		for (i = 0; i < 256; ++i)
+			memory[i] = i;
+		this->d = new Dram(2);
+		this->d->load(memory);
+	}
+
+	~DM() { delete this->d; }
+
+	/**
+	 * Ticks `dma' until its transfer completes.
+	 * @return the number of cycles taken
+	 */
+	int
+	drain(Dma &dma)
+	{
+		int i;
+
+		for (i = 1; !dma.tick(); ++i)
+			REQUIRE(i < 1000);
+		return i;
+	}
+
+	Dram *d;
+};
+
+TEST_CASE_METHOD(DM, "copy a block of lines", "[dma]")
+{
+	Dma dma(this->d, 0, 2);
+	int i, cycles;
+
+	REQUIRE(dma.copy_block(0, 512, 8));
+	CHECK(dma.is_busy());
+	CHECK(!dma.copy_block(0, 1024, 8));
+	cycles = this->drain(dma);
+
+	for (i = 0; i < 8; ++i) {
+		std::array<signed int, LINE_SIZE> expected = {4 * i, 4 * i + 1, 4 * i + 2, 4 * i + 3};
+		REQUIRE(this->d->view_line(128 + i) == expected);
+	}
+	// each line is read and written once, with no idle cycles between requests
+	CHECK(cycles <= 16 * 3);
+	CHECK(dma.get_cycles() == static_cast<unsigned long>(cycles));
+	CHECK(dma.get_bandwidth() == 32.0 / cycles);
+}
+
+TEST_CASE_METHOD(DM, "fill a block of lines", "[dma]")
+{
+	Dma dma(this->d, 0, 1);
+	std::array<signed int, LINE_SIZE> line = {7, 7, 7, 7};
+	int i;
+
+	REQUIRE(dma.fill_block(64, line, 4));
+	CHECK(this->drain(dma) == 4 * 3);
+	CHECK(dma.get_bandwidth() == 16.0 / 12);
+	for (i = 16; i < 20; ++i)
+		REQUIRE(this->d->view_line(i) == line);
+	CHECK_THROWS_AS(dma.copy_block(0, 8, 4), std::invalid_argument);
+}
+
+TEST_CASE_METHOD(DM, "coherent transfers bypass but respect upper caches", "[dma]")
+{
+	Cache *c;
+	Dma dma(this->d, 1, 2);
+	int id, i;
+	signed int w;
+	std::array<signed int, LINE_SIZE> expected;
+
+	c = new Cache(this->d, 5, 0, 1);
+	// dirty a source line, and cache a destination line
+	for (i = 1; !c->write_word(&id, 0x55, 1); ++i)
+		REQUIRE(i < 100);
+	for (i = 1; !c->read_word(&id, 517, w); ++i)
+		REQUIRE(i < 100);
+	CHECK(w == 0);
+
+	REQUIRE(dma.copy_block(0, 512, 2));
+	this->drain(dma);
+	CHECK(this->d->get_stat(BACK_INVALIDATIONS) == 2);
+
+	expected = {0, 0x55, 2, 3};
+	REQUIRE(this->d->view_line(0) == expected);
+	REQUIRE(this->d->view_line(128) == expected);
+	for (i = 1; !c->read_word(&id, 517, w); ++i)
+		REQUIRE(i < 100);
+	CHECK(w == 5);
+
+	// `c' owns `d'
+	delete c;
+	this->d = nullptr;
+}
+
+TEST_CASE_METHOD(DM, "coherent transfers merge the dirty words of a sectored cache", "[dma]")
+{
+	Cache *c;
+	Dma dma(this->d, 1, 2);
+	int id, i;
+	std::array<signed int, LINE_SIZE> expected;
+
+	// `c' holds only the word it wrote of line 1
+	c = new Cache(this->d, 5, 0, 1);
+	c->set_sectors(2, 0);
+	for (i = 1; !c->write_word(&id, 0x55, 5); ++i)
+		REQUIRE(i < 100);
+
+	// line 0 is read first, so the line buffer holds none of line 1's words
+	REQUIRE(dma.copy_block(0, 512, 2));
+	this->drain(dma);
+
+	expected = {4, 0x55, 6, 7};
+	REQUIRE(this->d->view_line(1) == expected);
+	REQUIRE(this->d->view_line(129) == expected);
+
+	delete c;
+	this->d = nullptr;
+}
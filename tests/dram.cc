@@ -1,5 +1,6 @@
 #include "dram.h"
 #include <array>
+#include <string>
 #include <catch2/catch_test_macros.hpp>
 
 class D
@@ -12,7 +13,7 @@ class D
 		this->mem = new int;
 		this->fetch = new int;
 		this->expected = {0, 0, 0, 0};
-		this->actual = this->d->get_data()[0];
+		this->actual = this->d->view_line(0);
 	}
 
 	~D()
@@ -31,7 +32,7 @@ class D
 			// check response
 			CHECK(!r);
 			// check for early modifications
-			actual = d->get_data()[0];
+			actual = d->view_line(0);
 			REQUIRE(this->expected == this->actual);
 		}
 	}
@@ -58,7 +59,7 @@ TEST_CASE_METHOD(D, "store 0th element in DELAY cycles", "[dram]")
 
 	CHECK(r);
 	expected.at(0) = w;
-	actual = this->d->get_data()[0];
+	actual = this->d->view_line(0);
 	REQUIRE(expected == actual);
 }
 
@@ -76,7 +77,7 @@ TEST_CASE_METHOD(D, "store 0th, 1st element in DELAY cycles, no conflict", "[dra
 	REQUIRE(r);
 
 	expected.at(0) = w;
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 
 	this->wait_for_storage(
@@ -85,7 +86,7 @@ TEST_CASE_METHOD(D, "store 0th, 1st element in DELAY cycles, no conflict", "[dra
 	r = d->write_word(this->fetch, w, 0x1);
 	CHECK(r);
 
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	expected.at(1) = w;
 	REQUIRE(expected == actual);
 }
@@ -104,7 +105,7 @@ TEST_CASE_METHOD(D, "store 0th element in DELAY cycles with conflict", "[dram]")
 		CHECK(!r);
 
 		// check for early modifications
-		actual = d->get_data()[0];
+		actual = d->view_line(0);
 		REQUIRE(expected == actual);
 	}
 
@@ -112,7 +113,7 @@ TEST_CASE_METHOD(D, "store 0th element in DELAY cycles with conflict", "[dram]")
 	REQUIRE(r);
 
 	expected.at(0) = w;
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 
 	this->wait_for_storage(
@@ -121,7 +122,7 @@ TEST_CASE_METHOD(D, "store 0th element in DELAY cycles with conflict", "[dram]")
 	r = d->write_word(this->fetch, w, 0x1);
 	CHECK(r);
 
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	expected.at(1) = w;
 	REQUIRE(expected == actual);
 }
@@ -141,7 +142,7 @@ TEST_CASE_METHOD(D, "store line in DELAY cycles", "[dram]")
 	r = d->write_line(this->mem, buffer, 0x0);
 	CHECK(r);
 
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	expected = buffer;
 	REQUIRE(expected == actual);
 }
@@ -162,7 +163,7 @@ TEST_CASE_METHOD(D, "store line in DELAY cycles no conflict", "[dram]")
 	REQUIRE(r);
 
 	expected = buffer;
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 
 	buffer = {w + 4, w + 5, w + 6, w + 7};
@@ -173,7 +174,7 @@ TEST_CASE_METHOD(D, "store line in DELAY cycles no conflict", "[dram]")
 	CHECK(r);
 
 	expected = buffer;
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 }
 
@@ -193,14 +194,14 @@ TEST_CASE_METHOD(D, "store line in DELAY cycles with conflict", "[dram]")
 		CHECK(!r);
 
 		// check for early modifications
-		actual = d->get_data()[0];
+		actual = d->view_line(0);
 		REQUIRE(expected == actual);
 	}
 
 	r = d->write_line(this->mem, buffer, 0x0);
 	CHECK(r);
 
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	expected = buffer;
 	REQUIRE(expected == actual);
 
@@ -212,7 +213,7 @@ TEST_CASE_METHOD(D, "store line in DELAY cycles with conflict", "[dram]")
 	CHECK(r);
 
 	expected = buffer;
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 }
 
@@ -299,7 +300,7 @@ TEST_CASE_METHOD(
 	r = d->write_line(this->mem, expected, addr);
 	CHECK(r);
 
-	actual = d->get_data()[0];
+	actual = d->view_line(0);
 	REQUIRE(expected == actual);
 
 	for (i = 0; i < LINE_SIZE; ++i) {
@@ -316,3 +317,71 @@ TEST_CASE_METHOD(
 		a = 0;
 	}
 }
+
+/**
+ * Has each of `ids' ask `d' for `n' words, in order every cycle. The last starts asking first,
+ * and each of the others one cycle after the one behind it.
+ * @return the positions in `ids' of the requesters, in the order their requests completed
+ */
+static std::string
+contend(Dram *d, std::array<int, 3> &ids, int n)
+{
+	std::array<int, 3> done;
+	std::string order;
+	signed int w;
+	int i, cycle;
+
+	done = {0, 0, 0};
+	for (cycle = 0; order.size() < 3 * static_cast<unsigned long>(n); ++cycle) {
+		REQUIRE(cycle < 1000);
+		for (i = 0; i < 3; ++i)
+			if (cycle >= 2 - i && done[i] < n && d->read_word(&ids[i], 0, w)) {
+				++done[i];
+				order += 'a' + i;
+			}
+	}
+	return order;
+}
+
+TEST_CASE_METHOD(D, "arbitrate between waiting requesters", "[dram]")
+{
+	std::array<int, 3> ids;
+
+	SECTION("a free level goes to the first to ask")
+	{
+		CHECK(contend(this->d, ids, 1) == "cab");
+		// `b' has waited longer than `a'
+		CHECK(this->d->get_wait_cycles(&ids[0]) == 2);
+		CHECK(this->d->get_wait_cycles(&ids[1]) == 6);
+		CHECK(this->d->get_stat(QUEUE_CYCLES) == 8);
+	}
+
+	SECTION("a free level goes to the next requester round-robin")
+	{
+		this->d->set_arbitration(ROUND_ROBIN, 0);
+		CHECK(contend(this->d, ids, 1) == "cba");
+		CHECK(contend(this->d, ids, 2) == "cbacba");
+	}
+
+	SECTION("a free level goes to the requester which has waited longest")
+	{
+		this->d->set_arbitration(OLDEST, 0);
+		CHECK(contend(this->d, ids, 1) == "cba");
+		CHECK(this->d->get_wait_cycles(&ids[0]) == 6);
+		CHECK(this->d->get_wait_cycles(&ids[1]) == 3);
+	}
+
+	SECTION("a free level goes to the highest priority requester")
+	{
+		this->d->set_arbitration(PRIORITY, 0);
+		this->d->set_priority(&ids[0], 1);
+		CHECK(contend(this->d, ids, 2) == "cabacb");
+	}
+
+	SECTION("requesters are refused without waiting in order when the queue is full")
+	{
+		this->d->set_arbitration(OLDEST, 1);
+		CHECK(contend(this->d, ids, 1) == "cba");
+		CHECK(this->d->get_stat(QUEUE_FULL) == 3);
+	}
+}
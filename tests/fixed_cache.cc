@@ -0,0 +1,120 @@
+#include "cache.h"
+#include "dram.h"
+#include "fixed_cache.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+
+/**
+ * Calls `f' until it reports completion.
+ * @return the number of cycles taken
+ */
+static int
+run(std::function<int()> f)
+{
+	int i;
+
+	for (i = 1; !f(); ++i)
+		REQUIRE(i < 1000);
+	return i;
+}
+
+TEST_CASE("fixed cache matches the timing of a runtime cache", "[fixed_cache]")
+{
+	int mem, m_delay, c_delay, cycles;
+	signed int w;
+	FixedCache<5, 0> *c;
+	std::array<signed int, LINE_SIZE> expected;
+
+	m_delay = 4;
+	c_delay = 2;
+	c = new FixedCache<5, 0>(new Dram(m_delay), c_delay);
+
+	w = 0x11223344;
+	cycles = run([&]() { return c->write_word(&mem, w, 0b1); });
+	CHECK(cycles == m_delay + c_delay + 2);
+	expected = {0, w, 0, 0};
+	REQUIRE(expected == c->view_line(0));
+
+	// conflicting tag, write back then fetch
+	cycles = run([&]() { return c->read_word(&mem, 0b10000001, w); });
+	CHECK(cycles == m_delay + m_delay + c_delay + 3);
+	CHECK(c->get_stat(WRITEBACKS) == 1);
+	CHECK(c->get_stat(MISSES) == 2);
+
+	delete c;
+}
+
+TEST_CASE("fixed cache matches the contents of a runtime cache", "[fixed_cache]")
+{
+	int mem, i, address;
+	signed int a, b;
+	Dram *da, *db;
+	Cache *ca;
+	FixedCache<3, 2> *cb;
+
+	da = new Dram(1);
+	db = new Dram(1);
+	ca = new Cache(da, 5, 2, 1);
+	cb = new FixedCache<3, 2>(db, 1);
+
+	for (i = 0; i < 600; ++i) {
+		address = (i * 37 + (i >> 3) * 1024) % 4096;
+		if (i % 3) {
+			run([&]() { return ca->read_word(&mem, address, a); });
+			run([&]() { return cb->read_word(&mem, address, b); });
+			REQUIRE(a == b);
+		} else {
+			run([&]() { return ca->write_word(&mem, i, address); });
+			run([&]() { return cb->write_word(&mem, i, address); });
+		}
+	}
+
+	CHECK(ca->get_stat(HITS) == cb->get_stat(HITS));
+	CHECK(ca->get_stat(MISSES) == cb->get_stat(MISSES));
+	CHECK(ca->get_stat(WRITEBACKS) == cb->get_stat(WRITEBACKS));
+	REQUIRE(da->get_data() == db->get_data());
+	REQUIRE(ca->get_data() == cb->get_data());
+
+	delete ca;
+	delete cb;
+}
+
+TEST_CASE("fixed cache flushes to memory", "[fixed_cache]")
+{
+	int mem;
+	Dram *d;
+	FixedCache<3, 1> *c;
+
+	d = new Dram(1);
+	c = new FixedCache<3, 1>(d, 1);
+	run([&]() { return c->write_word(&mem, 0x55, 0b100101); });
+	run([&]() { return c->clean(&mem, 0, 8); });
+	CHECK(d->view_line(9).at(1) == 0);
+	run([&]() { return c->flush(&mem); });
+	CHECK(d->view_line(9).at(1) == 0x55);
+	CHECK(c->get_stat(WRITEBACKS) == 1);
+
+	delete c;
+}
+
+TEST_CASE("fixed cache writes a flush back as one burst", "[fixed_cache]")
+{
+	int mem, i;
+	Cache *rc;
+	FixedCache<5, 0> *fc;
+
+	rc = new Cache(new Dram(4), 5, 0, 1);
+	fc = new FixedCache<5, 0>(new Dram(4), 1);
+	for (i = 0; i < 8; ++i) {
+		run([&]() { return rc->write_word(&mem, i, i << LINE_SPEC); });
+		run([&]() { return fc->write_word(&mem, i, i << LINE_SPEC); });
+	}
+
+	CHECK(run([&]() { return fc->flush(&mem); }) == run([&]() { return rc->flush(&mem); }));
+	CHECK(fc->get_stat(WRITEBACKS) == 8);
+	CHECK(fc->get_lower()->view_line(7).at(0) == 7);
+
+	delete rc;
+	delete fc;
+}
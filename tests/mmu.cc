@@ -0,0 +1,104 @@
+#include "cache.h"
+#include "dram.h"
+#include "mmu.h"
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * Two level page tables over a single level cache.
+ * PAGE: OFFSET=6(64), LEVEL1=3(8), LEVEL2=3(8)
+ * The root table is at physical page 1 and maps virtual pages 0-7 through the table at physical
+ * page 2. Virtual pages 1 and 3 map to physical pages 6 and 5, and virtual page 4 is unmapped.
+ */
+class M
+{
+  public:
+	M()
+	{
+		std::vector<signed int> memory(512, 0);
+
+		memory[64 + 0] = MAKE_PTE(2);
+		memory[128 + 1] = MAKE_PTE(6);
+		memory[128 + 3] = MAKE_PTE(5);
+		memory[320 + 7] = 0x55;
+		this->d = new Dram(4);
+		this->d->load(memory);
+		this->c = new Cache(this->d, 5, 0, 2);
+		this->m = new Mmu(this->c, new Tlb(1, 0, 0), new Tlb(3, 1, 1), 6, 3, 2, 64);
+	}
+
+	~M() { delete this->m; }
+
+	/**
+	 * Calls `f' until it reports completion.
+	 * @return the number of cycles taken
+	 */
+	int
+	run(std::function<int()> f)
+	{
+		int i;
+
+		for (i = 1; !f(); ++i)
+			REQUIRE(i < 1000);
+		return i;
+	}
+
+	int id;
+	Dram *d;
+	Cache *c;
+	Mmu *m;
+};
+
+TEST_CASE_METHOD(M, "translate through a page table walk, then the TLB", "[mmu]")
+{
+	signed int w;
+	int walked, cached;
+
+	walked = this->run([this, &w]() { return this->m->read_word(&this->id, 192 + 7, w); });
+	CHECK(w == 0x55);
+	CHECK(this->m->get_stat(TLB_L1_MISSES) == 1);
+	CHECK(this->m->get_stat(TLB_L2_MISSES) == 1);
+	CHECK(this->m->get_stat(WALKS) == 1);
+	CHECK(this->m->get_stat(WALK_CYCLES) > 0);
+	// page table reads compete for the cache
+	CHECK(this->c->get_stat(MISSES) == 3);
+
+	cached = this->run([this, &w]() { return this->m->read_word(&this->id, 192 + 7, w); });
+	CHECK(w == 0x55);
+	CHECK(cached < walked);
+	CHECK(this->m->get_stat(WALKS) == 1);
+
+	this->run([this, &w]() { return this->m->write_word(&this->id, 0x66, 192 + 8); });
+	this->run([this, &w]() { return this->c->read_word(&this->id, 320 + 8, w); });
+	CHECK(w == 0x66);
+}
+
+TEST_CASE_METHOD(M, "second level TLB refills the first", "[mmu]")
+{
+	signed int w;
+
+	// virtual pages 1 and 3 conflict in the first level only
+	this->run([this, &w]() { return this->m->read_word(&this->id, 192, w); });
+	this->run([this, &w]() { return this->m->read_word(&this->id, 64, w); });
+	this->run([this, &w]() { return this->m->read_word(&this->id, 192, w); });
+	CHECK(this->m->get_stat(TLB_L1_MISSES) == 3);
+	CHECK(this->m->get_stat(TLB_L2_MISSES) == 2);
+	CHECK(this->m->get_stat(WALKS) == 2);
+
+	this->m->flush_tlbs();
+	this->run([this, &w]() { return this->m->read_word(&this->id, 192, w); });
+	CHECK(this->m->get_stat(WALKS) == 3);
+}
+
+TEST_CASE_METHOD(M, "unmapped pages fault", "[mmu]")
+{
+	signed int w;
+
+	REQUIRE_THROWS_AS(
+		this->run([this, &w]() { return this->m->read_word(&this->id, 256, w); }),
+		std::out_of_range);
+	// the unit is usable after a fault
+	this->run([this, &w]() { return this->m->read_word(&this->id, 192 + 7, w); });
+	CHECK(w == 0x55);
+}
@@ -0,0 +1,124 @@
+#include "cache.h"
+#include "dram.h"
+#include "scheduler.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <vector>
+
+static Scheduler::Task
+copy_words(Scheduler &s, Storage &storage, int src, int dst, int n, std::vector<signed int> &read)
+{
+	signed int w;
+	int i;
+
+	for (i = 0; i < n; ++i) {
+		w = co_await s.read_word(storage, src + i);
+		read.push_back(w);
+		co_await s.write_word(storage, w, dst + i);
+	}
+}
+
+static Scheduler::Task
+write_then_sleep(Scheduler &s, Storage &storage, int address, int cycles, unsigned long &done)
+{
+	std::array<signed int, LINE_SIZE> line;
+
+	co_await s.write_line(storage, {1, 2, 3, 4}, address);
+	co_await s.sleep(cycles);
+	line = co_await s.read_line(storage, address);
+	CHECK(line == std::array<signed int, LINE_SIZE>{1, 2, 3, 4});
+	done = s.now();
+}
+
+static Scheduler::Task
+fail(Scheduler &s, Storage &storage)
+{
+	co_await s.read_word(storage, 0);
+	throw std::runtime_error("task failed");
+}
+
+TEST_CASE("a task takes as many cycles as the same requests issued by hand", "[scheduler]")
+{
+	std::vector<signed int> memory(64), read;
+	Scheduler s;
+	Dram *da, *db;
+	Cache *a, *b;
+	signed int w;
+	int i, id, cycles;
+
+	for (i = 0; i < 64; ++i)
+		memory[i] = i * 3;
+	da = new Dram(4);
+	db = new Dram(4);
+	da->load(memory);
+	db->load(memory);
+	a = new Cache(da, 5, 0, 2);
+	b = new Cache(db, 5, 0, 2);
+
+	cycles = 0;
+	for (i = 0; i < 6; ++i) {
+		while (++cycles, !a->read_word(&id, i, w))
+			;
+		while (++cycles, !a->write_word(&id, w, 32 + i))
+			;
+	}
+
+	s.spawn(copy_words(s, *b, 0, 32, 6, read));
+	CHECK(s.run() == static_cast<unsigned long>(cycles));
+	CHECK(read == std::vector<signed int>{0, 3, 6, 9, 12, 15});
+	CHECK(b->get_stat(HITS) == a->get_stat(HITS));
+	CHECK(b->get_stat(MISSES) == a->get_stat(MISSES));
+
+	delete a;
+	delete b;
+}
+
+TEST_CASE("many tasks share a level", "[scheduler]")
+{
+	std::vector<std::vector<signed int>> read(1000);
+	std::vector<signed int> memory(1000);
+	Scheduler s;
+	Dram d(3);
+	int i;
+
+	for (i = 0; i < 1000; ++i)
+		memory[i] = i;
+	d.load(memory);
+
+	for (i = 0; i < 1000; ++i)
+		s.spawn(copy_words(s, d, i, 1000 + i, 1, read[i]));
+	// each access is granted the cycle the one before it completes
+	CHECK(s.run() == 1 + 2000 * 3);
+	for (i = 0; i < 1000; ++i) {
+		REQUIRE(read[i] == std::vector<signed int>{i});
+		REQUIRE(d.view_line((1000 + i) / LINE_SIZE).at(i % LINE_SIZE) == i);
+	}
+}
+
+TEST_CASE("tasks sleep and resume on their completion cycle", "[scheduler]")
+{
+	Scheduler s;
+	Dram d(3);
+	unsigned long first, second;
+
+	s.spawn(write_then_sleep(s, d, 0, 10, first));
+	s.spawn(write_then_sleep(s, d, 4, 1, second));
+	s.run();
+	// the second write is granted as the first completes, then overtakes it while it sleeps
+	CHECK(second == 4 + 3 + 1 + 4);
+	CHECK(first == 4 + 10 + 4);
+	CHECK(s.now() == first);
+	CHECK_THROWS_AS(s.sleep(0), std::invalid_argument);
+}
+
+TEST_CASE("exceptions thrown by tasks propagate out of run", "[scheduler]")
+{
+	Scheduler s;
+	Dram d(1);
+	std::vector<signed int> read;
+
+	s.spawn(copy_words(s, d, 0, 64, 4, read));
+	s.spawn(fail(s, d));
+	CHECK_THROWS_AS(s.run(), std::runtime_error);
+}
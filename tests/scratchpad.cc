@@ -0,0 +1,125 @@
+#include "cache.h"
+#include "dma.h"
+#include "dram.h"
+#include "router.h"
+#include "scratchpad.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * A scratchpad at 0x100 shared by a router in front of a cache, for compute, and a router in front
+ * of memory, for DMA.
+ */
+class SP
+{
+  public:
+	SP()
+	{
+		std::vector<signed int> memory(1024);
+		int i;
+
+		for (i = 0; i < 1024; ++i)
+			memory[i] = i;
+		this->d = new Dram(10);
+		this->d->load(memory);
+		this->s = new Scratchpad(0x100, 16, 1);
+		this->fill = new Router(this->d, this->s);
+		this->fill->share_lower();
+		this->c = new Cache(this->d, 5, 0, 1);
+		this->c->share_lower();
+		this->core = new Router(this->c, this->s);
+	}
+
+	~SP()
+	{
+		delete this->core;
+		delete this->fill;
+		delete this->s;
+		delete this->d;
+	}
+
+	/**
+	 * Calls `f' until it reports completion, ticking `dma' each cycle.
+	 * @return the number of cycles taken
+	 */
+	int
+	run_until_done(std::function<int()> f, Dma &dma)
+	{
+		int i;
+
+		for (i = 1; !f(); ++i) {
+			dma.tick();
+			REQUIRE(i < 1000);
+		}
+		dma.tick();
+		return i;
+	}
+
+	Dram *d;
+	Scratchpad *s;
+	Router *fill;
+	Cache *c;
+	Router *core;
+};
+
+TEST_CASE_METHOD(SP, "scratchpad accesses take a fixed latency", "[scratchpad]")
+{
+	Dma dma(this->fill, 0, 2);
+	signed int w;
+	int i, cycles;
+
+	for (i = 0; i < 4; ++i) {
+		// like memory, an access takes one cycle more than the delay
+		cycles = this->run_until_done(
+			[this, i]() { return this->core->write_word(this, i + 1, 0x100 + i * 8); }, dma);
+		CHECK(cycles == 2);
+		cycles = this->run_until_done(
+			[this, &w, i]() { return this->core->read_word(this, 0x100 + i * 8, w); }, dma);
+		CHECK(cycles == 2);
+		CHECK(w == i + 1);
+	}
+	CHECK(this->s->view_line(2).at(0) == 2);
+	CHECK(this->c->get_stat(MISSES) == 0);
+	CHECK(this->d->view_line(0x100 / LINE_SIZE).at(0) == 0x100);
+
+	// addresses outside the scratchpad go to the cache
+	this->run_until_done([this, &w]() { return this->core->read_word(this, 0x20, w); }, dma);
+	CHECK(w == 0x20);
+	CHECK(this->c->get_stat(MISSES) == 1);
+	CHECK_THROWS_AS(this->s->read_word(this, 0x20, w), std::out_of_range);
+	CHECK_THROWS_AS(Scratchpad(0x102, 4, 1), std::invalid_argument);
+	CHECK_THROWS_AS(Scratchpad(0, MEM_LINES + 1, 1), std::invalid_argument);
+}
+
+TEST_CASE_METHOD(SP, "DMA fills and drains the scratchpad alongside compute", "[scratchpad]")
+{
+	Dma dma(this->fill, 0, 2);
+	signed int w;
+	int i, cycles;
+
+	REQUIRE(dma.copy_block(0x200, 0x100, 16));
+	// misses in the cache wait on memory behind the DMA reads, but still complete
+	cycles = 0;
+	for (i = 0; i < 8; ++i)
+		cycles += this->run_until_done(
+			[this, &w, i]() { return this->core->read_word(this, i * LINE_SIZE, w); }, dma);
+	while (!dma.tick())
+		++cycles;
+	CHECK(static_cast<unsigned long>(cycles) < dma.get_cycles() + 8 * 11);
+
+	for (i = 0; i < 16; ++i) {
+		std::array<signed int, LINE_SIZE> expected = {
+			0x200 + 4 * i, 0x200 + 4 * i + 1, 0x200 + 4 * i + 2, 0x200 + 4 * i + 3};
+		REQUIRE(this->s->view_line(i) == expected);
+	}
+
+	// results computed in the scratchpad are drained back to memory
+	this->run_until_done([this]() { return this->core->write_word(this, -1, 0x104); }, dma);
+	REQUIRE(dma.copy_block(0x100, 0x300, 16));
+	while (!dma.tick())
+		;
+	CHECK(this->d->view_line(0x300 / LINE_SIZE + 1).at(0) == -1);
+	CHECK(this->d->view_line(0x300 / LINE_SIZE + 2).at(0) == 0x208);
+}
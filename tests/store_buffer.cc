@@ -0,0 +1,125 @@
+#include "cache.h"
+#include "dram.h"
+#include "store_buffer.h"
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+class SB
+{
+  public:
+	SB()
+	{
+		this->d = new Dram(4);
+		this->c = new Cache(this->d, 5, 0, 2);
+		this->s = new StoreBuffer(this->c, 2);
+	}
+
+	~SB() { delete this->s; }
+
+	/**
+	 * Calls `f', then ticks the buffer, until `f' reports completion.
+	 * @return the number of cycles taken
+	 */
+	int
+	run_until_done(std::function<int()> f)
+	{
+		int i, r;
+
+		for (i = 1;; ++i) {
+			REQUIRE(i < 1000);
+			r = f();
+			this->s->tick();
+			if (r)
+				return i;
+		}
+	}
+
+	Dram *d;
+	Cache *c;
+	StoreBuffer *s;
+	int id;
+};
+
+TEST_CASE_METHOD(SB, "stores retire immediately and merge by line", "[store_buffer]")
+{
+	CHECK(this->s->write_word(&this->id, 1, 0));
+	CHECK(this->s->write_word(&this->id, 2, 1));
+	CHECK(this->s->write_word(&this->id, 3, 8));
+	CHECK(this->s->get_occupancy() == 2);
+	CHECK(this->s->get_stat(STORE_MERGES) == 1);
+
+	// full until the first line has drained
+	CHECK(!this->s->write_word(&this->id, 4, 16));
+	CHECK(this->s->get_stat(STORE_STALLS) == 1);
+	CHECK(this->run_until_done([this]() { return this->s->write_word(&this->id, 4, 16); }) > 1);
+	CHECK(this->s->get_occupancy() == 2);
+
+	CHECK(this->run_until_done([this]() { return this->s->fence(&this->id); }) > 1);
+	CHECK(this->s->get_occupancy() == 0);
+	CHECK(this->c->view_line(0) == std::array<signed int, LINE_SIZE>{1, 2, 0, 0});
+	CHECK(this->c->view_line(2) == std::array<signed int, LINE_SIZE>{3, 0, 0, 0});
+	CHECK(this->c->view_line(4) == std::array<signed int, LINE_SIZE>{4, 0, 0, 0});
+	CHECK_THROWS_AS(StoreBuffer(nullptr, 0), std::invalid_argument);
+}
+
+TEST_CASE_METHOD(SB, "a merged partial line drains in one request", "[store_buffer]")
+{
+	REQUIRE(this->s->write_word(&this->id, 1, 4));
+	REQUIRE(this->s->write_word(&this->id, 2, 5));
+	REQUIRE(this->s->write_word(&this->id, 3, 7));
+	CHECK(this->s->get_stat(STORE_MERGES) == 2);
+
+	this->run_until_done([this]() { return this->s->fence(&this->id); });
+	CHECK(this->c->get_stat(REQUESTS) == 1);
+	CHECK(this->c->view_line(1) == std::array<signed int, LINE_SIZE>{1, 2, 0, 3});
+}
+
+TEST_CASE_METHOD(SB, "loads are forwarded from buffered stores", "[store_buffer]")
+{
+	std::array<signed int, LINE_SIZE> line;
+	signed int w;
+
+	REQUIRE(this->s->write_word(&this->id, 7, 2));
+	REQUIRE(this->s->write_word(&this->id, 9, 2));
+	CHECK(this->s->read_word(&this->id, 2, w));
+	CHECK(w == 9);
+	CHECK(this->s->get_stat(STORE_FORWARDS) == 1);
+
+	// words not buffered come from below, merged under the buffered ones
+	CHECK(this->run_until_done([this, &line]() { return this->s->read_line(&this->id, 0, line); }) > 1);
+	CHECK(line == std::array<signed int, LINE_SIZE>{0, 0, 9, 0});
+	CHECK(this->run_until_done([this, &w]() { return this->s->read_word(&this->id, 3, w); }) > 1);
+	CHECK(w == 0);
+
+	// only the words asked for are merged, whichever they are
+	REQUIRE(this->s->write_word(&this->id, 0x55, 1));
+	line = {-1, -1, -1, -1};
+	this->run_until_done([this, &line]() { return this->s->read_words(&this->id, 0, 0b0010, line); });
+	CHECK(line == std::array<signed int, LINE_SIZE>{-1, 0x55, -1, -1});
+	line = {-1, -1, -1, -1};
+	this->run_until_done([this, &line]() { return this->s->read_words(&this->id, 0, 0b0001, line); });
+	CHECK(line == std::array<signed int, LINE_SIZE>{0, -1, -1, -1});
+}
+
+TEST_CASE_METHOD(SB, "a store-heavy loop does not wait for each store", "[store_buffer]")
+{
+	Cache *direct;
+	int i, buffered, unbuffered;
+
+	direct = new Cache(new Dram(4), 5, 0, 2);
+	buffered = unbuffered = 0;
+	for (i = 0; i < 16; ++i) {
+		buffered += this->run_until_done([this, i]() { return this->s->write_word(&this->id, i, i); });
+		unbuffered += this->run_until_done([direct, this, i]() { return direct->write_word(&this->id, i, i); });
+	}
+	buffered += this->run_until_done([this]() { return this->s->fence(&this->id); });
+
+	// the buffer writes each word while the requester carries on
+	CHECK(buffered < unbuffered);
+	for (i = 0; i < 4; ++i)
+		CHECK(this->c->view_line(i) == direct->view_line(i));
+
+	delete direct;
+}
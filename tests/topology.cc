@@ -0,0 +1,138 @@
+#include "cache.h"
+#include "dram.h"
+#include "icache.h"
+#include "store_buffer.h"
+#include "topology.h"
+#include <catch2/catch_test_macros.hpp>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * Split instruction and data caches over a unified, inclusive level 2
+ */
+class Split
+{
+  public:
+	Split()
+	{
+		this->d = new Dram(4);
+		this->t.add("dram", this->d);
+		this->l2 = new Cache(this->d, 7, 0, 2);
+		this->l2->set_inclusion(INCLUSIVE);
+		this->t.add("l2", this->l2);
+		this->l1i = new ICache(this->l2, 5, 0, 1);
+		this->t.add("l1i", this->l1i);
+		this->l1d = new Cache(this->l2, 5, 0, 1);
+		this->t.add("l1d", this->l1d);
+	}
+
+	/**
+	 * Calls `f' until it reports completion, ticking the hierarchy each cycle.
+	 * @return the number of cycles taken
+	 */
+	int
+	run(std::function<int()> f)
+	{
+		int i;
+
+		for (i = 1; !f(); ++i) {
+			this->t.tick();
+			REQUIRE(i < 1000);
+		}
+		this->t.tick();
+		return i;
+	}
+
+	Topology t;
+	Dram *d;
+	Cache *l2;
+	ICache *l1i;
+	Cache *l1d;
+	int fetch;
+	int load;
+};
+
+TEST_CASE_METHOD(Split, "split level 1 caches share level 2", "[topology]")
+{
+	signed int w;
+	int i_done, d_done;
+
+	this->run([this, &w]() { return this->l1i->read_word(&this->fetch, 0b0, w); });
+	this->run([this, &w]() { return this->l1d->read_word(&this->load, 0b1, w); });
+	CHECK(this->l2->get_stat(MISSES) == 1);
+	CHECK(this->l2->get_stat(HITS) == 1);
+
+	// data stores do not reach the instruction cache
+	this->run([this]() { return this->l1d->write_word(&this->load, 0x11, 0b100000000); });
+	CHECK(this->l1i->get_stat(MISSES) == 1);
+	CHECK(this->l1i->get_stat(HITS) == 0);
+	CHECK_THROWS_AS(this->l1i->write_word(&this->fetch, 0x11, 0b0), std::invalid_argument);
+
+	// both miss at once, and one waits on level 2
+	i_done = d_done = 0;
+	while (!i_done || !d_done) {
+		i_done = i_done || this->l1i->read_word(&this->fetch, 0b1000000, w);
+		d_done = d_done || this->l1d->read_word(&this->load, 0b10000000, w);
+		this->t.tick();
+	}
+	CHECK(this->l2->get_stat(QUEUE_CYCLES) > 0);
+	CHECK(this->l2->get_stat(MISSES) == 4);
+}
+
+TEST_CASE_METHOD(Split, "inclusive level 2 back-invalidates the instruction cache", "[topology]")
+{
+	signed int w;
+
+	this->run([this, &w]() { return this->l1i->read_word(&this->fetch, 0b0, w); });
+	CHECK(this->l1i->get_tag(0) == 0);
+
+	// conflicts with line 0 in level 2, but not in level 1 data
+	this->run([this, &w]() { return this->l1d->read_word(&this->load, 1 << 9, w); });
+	CHECK(this->l2->get_stat(BACK_INVALIDATIONS) == 1);
+	CHECK(this->l1i->get_tag(0) == -1);
+
+	std::vector<Level> tops = this->t.get_tops();
+	REQUIRE(tops.size() == 2);
+	CHECK(tops[0].storage == this->l1i);
+	CHECK(tops[1].storage == this->l1d);
+
+	Dram *extra = new Dram(1);
+	CHECK_THROWS_AS(this->t.add("l2", extra), std::invalid_argument);
+	delete extra;
+}
+
+TEST_CASE_METHOD(Split, "levels below a store buffer are ticked once a cycle", "[topology]")
+{
+	int bare, buffered;
+
+	REQUIRE(this->l1d->prefetch(&this->load, 0b10000, 0));
+	bare = this->run([this]() { return this->l1d->get_stat(PREFETCHES) == 1; });
+
+	this->t.add("sb", new StoreBuffer(this->l1d, 2));
+	REQUIRE(this->l1d->prefetch(&this->load, 0b100000, 0));
+	buffered = this->run([this]() { return this->l1d->get_stat(PREFETCHES) == 2; });
+	CHECK(buffered == bare);
+}
+
+TEST_CASE("instruction cache matches the timing of a data cache", "[topology]")
+{
+	ICache *i;
+	Cache *c;
+	signed int w;
+	int id, ci, cc;
+
+	i = new ICache(new Dram(4), 5, 1, 2);
+	c = new Cache(new Dram(4), 5, 1, 2);
+	for (int address : {0, 1, 0b10000000, 0b100000000, 0b1000000000, 0}) {
+		for (ci = 1; !i->read_word(&id, address, w); ++ci)
+			;
+		for (cc = 1; !c->read_word(&id, address, w); ++cc)
+			;
+		CHECK(ci == cc);
+	}
+	CHECK(i->get_stat(HITS) == c->get_stat(HITS));
+	CHECK(i->get_stat(EVICTIONS) == c->get_stat(EVICTIONS));
+
+	delete i;
+	delete c;
+}
@@ -0,0 +1,119 @@
+#include "c11.h"
+#include "cache.h"
+#include "dram.h"
+#include "tracer.h"
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+
+class T : public C11
+{
+  public:
+	T() : C11(), t(4)
+	{
+		delete this->c;
+		this->d = new Dram(this->m_delay);
+		this->c = new Cache(this->d, 5, 0, this->c_delay);
+		this->c->set_tracer(&this->t, "l1");
+		this->d->set_tracer(&this->t, "dram");
+	}
+
+	/**
+	 * Calls `f' until it reports completion, advancing the tracer each cycle.
+	 */
+	void
+	run_traced(std::function<int()> f)
+	{
+		this->run_until_done([this, f]() {
+			this->t.tick();
+			return f();
+		});
+	}
+
+	Tracer t;
+	Dram *d;
+};
+
+TEST_CASE_METHOD(T, "trace a miss through two levels", "[tracer]")
+{
+	std::ostringstream out;
+	std::string json;
+	signed int w;
+
+	this->run_traced([this, &w]() { return this->c->read_word(this->mem, 0b101, w); });
+	this->t.write_chrome_trace(out);
+	json = out.str();
+
+	CHECK(json.find("\"name\":\"l1\"") != std::string::npos);
+	CHECK(json.find("\"name\":\"dram\"") != std::string::npos);
+	CHECK(json.find("{\"name\":\"miss\",\"pid\":0,\"tid\":0,\"ts\":1,") != std::string::npos);
+	CHECK(json.find("{\"name\":\"issue\",\"pid\":0,\"tid\":1,\"ts\":1,") != std::string::npos);
+	CHECK(
+		json.find("{\"name\":\"complete\",\"pid\":0,\"tid\":1,\"ts\":" +
+				  std::to_string(this->m_delay + 1)) != std::string::npos);
+	CHECK(
+		json.find(
+			"{\"name\":\"complete\",\"pid\":0,\"tid\":0,\"ts\":" +
+			std::to_string(this->m_delay + this->c_delay + 2) + ",\"ph\":\"E\"") !=
+		std::string::npos);
+
+	// buffers are drained by an export
+	out.str("");
+	this->t.write_chrome_trace(out);
+	CHECK(out.str().find("\"issue\"") == std::string::npos);
+}
+
+TEST_CASE_METHOD(T, "trace drops events outside the window or once full", "[tracer]")
+{
+	std::ostringstream out;
+	signed int w;
+	int i;
+
+	this->t.set_window(100, 200);
+	this->run_traced([this, &w]() { return this->c->read_word(this->mem, 0b101, w); });
+	this->t.write_chrome_trace(out);
+	CHECK(out.str().find("\"issue\"") == std::string::npos);
+
+	this->t.set_window(0, 1000);
+	for (i = 0; i < 20; ++i)
+		this->run_traced([this, &w, i]() { return this->c->read_word(this->mem, i << 7, w); });
+	CHECK(this->t.get_dropped(0) > 0);
+	CHECK(this->t.get_dropped(1) > 0);
+}
+
+TEST_CASE_METHOD(T, "trace clips requests to the window", "[tracer]")
+{
+	std::ostringstream out;
+	std::string json;
+	signed int w;
+
+	// level 1 serves the request over cycles 1 to 8, memory over cycles 1 to 5
+	this->t.set_window(3, 6);
+	this->run_traced([this, &w]() { return this->c->read_word(this->mem, 0b101, w); });
+	this->t.write_chrome_trace(out);
+	json = out.str();
+
+	CHECK(
+		json.find("{\"name\":\"issue\",\"pid\":0,\"tid\":0,\"ts\":3,\"ph\":\"B\"") !=
+		std::string::npos);
+	CHECK(
+		json.find("{\"name\":\"complete\",\"pid\":0,\"tid\":0,\"ts\":6,\"ph\":\"E\"") !=
+		std::string::npos);
+	CHECK(
+		json.find("{\"name\":\"issue\",\"pid\":0,\"tid\":1,\"ts\":3,\"ph\":\"B\"") !=
+		std::string::npos);
+	CHECK(
+		json.find("{\"name\":\"complete\",\"pid\":0,\"tid\":1,\"ts\":5,\"ph\":\"E\"") !=
+		std::string::npos);
+	CHECK(json.find("\"miss\"") == std::string::npos);
+}
+
+TEST_CASE("trace escapes level names", "[tracer]")
+{
+	std::ostringstream out;
+	Tracer t(2);
+
+	t.attach("l1 \"data\" \\ 0");
+	t.write_chrome_trace(out);
+	CHECK(out.str().find("\"name\":\"l1 \\\"data\\\" \\\\ 0\"") != std::string::npos);
+}